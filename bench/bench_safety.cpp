@@ -0,0 +1,206 @@
+﻿#include "safety_bitset.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// 安全性检查基准：对比逐哲学家分支的标量银行家不动点循环与位并行内核（标量 64 位 / AVX2）。
+// 用法：bench_safety [最大 N，默认 100000]
+// 每个 N 分别取叉子数 M = N、M < N 与 M > N（比例映射，与仿真相同），构造四类状态：
+//   random —— 随机让哲学家拿起叉子（只接受仍然安全的分配），接近仿真运行时的典型状态
+//   chain  —— 哲学家 i 持有叉子 i，只有最后一位空手，标量循环需要 O(N) 轮才能收敛（最坏情况，安全）
+//   cycle  —— 每把叉子都被以它为左叉子的某位哲学家拿着（M <= N 时成环，不安全）
+//   unsafe —— 不经安全检查随机分配叉子直到几乎全部被拿起（有人同时拿着两把时环会断开，M < N 时多数不安全）
+// 每种状态都先与标量银行家循环的结果核对，不一致时报错退出（链式状态超出标量规模上限时只核对两个位并行内核）
+
+namespace {
+
+struct Table {
+    int num_phil;
+    int num_forks;
+    std::vector<int> left_fork_of;
+    std::vector<int> right_fork_of;
+    std::vector<int> holder;
+};
+
+// 与 Simulation 相同的比例映射：left = i * M / N，right = left + 1（环绕）
+Table make_table(int n, int m) {
+    Table t;
+    t.num_phil = n;
+    t.num_forks = m;
+    t.left_fork_of.resize(n);
+    t.right_fork_of.resize(n);
+    for (int i = 0; i < n; ++i) {
+        t.left_fork_of[i] = static_cast<int>((static_cast<long long>(i) * m) / n);
+        t.right_fork_of[i] = (t.left_fork_of[i] + 1) % m;
+    }
+    t.holder.assign(m, -1);
+    return t;
+}
+
+// 原实现中的标量银行家不动点循环：反复扫描所有哲学家，能拿齐叉子的视为完成并归还其叉子
+bool scalar_banker_safe(const Table& t, std::vector<int>& available, std::vector<int>& need,
+                        std::vector<char>& finished) {
+    for (int f = 0; f < t.num_forks; ++f) available[f] = (t.holder[f] == -1) ? 1 : 0;
+    for (int i = 0; i < t.num_phil; ++i) {
+        need[i] = 0;
+        if (t.holder[t.left_fork_of[i]] != i) need[i]++;
+        if (t.holder[t.right_fork_of[i]] != i) need[i]++;
+        finished[i] = 0;
+    }
+    int remaining = t.num_phil;
+    bool progress = true;
+    while (progress && remaining > 0) {
+        progress = false;
+        for (int i = 0; i < t.num_phil; ++i) {
+            if (finished[i]) continue;
+            int l = t.left_fork_of[i];
+            int r = t.right_fork_of[i];
+            bool can_finish = need[i] == 0 ||
+                              ((available[l] || t.holder[l] == i) && (available[r] || t.holder[r] == i));
+            if (can_finish) {
+                if (t.holder[l] == i) available[l] = 1;
+                if (t.holder[r] == i) available[r] = 1;
+                finished[i] = 1;
+                --remaining;
+                progress = true;
+            }
+        }
+    }
+    return remaining == 0;
+}
+
+void fill_random(Table& t, unsigned seed) {
+    std::mt19937 rng(seed);
+    BitsetSafetyChecker checker(t.left_fork_of, t.right_fork_of, t.num_forks);
+    std::uniform_int_distribution<int> pick_phil(0, t.num_phil - 1);
+    for (int k = 0; k < t.num_phil; ++k) {
+        int i = pick_phil(rng);
+        int f = (rng() & 1) ? t.left_fork_of[i] : t.right_fork_of[i];
+        if (t.holder[f] == -1 && checker.is_safe_after_grant(i, f)) {
+            checker.set_holder(f, i);
+            t.holder[f] = i;
+        }
+    }
+}
+
+void fill_chain(Table& t) {
+    // 最后一位哲学家空手，否则成环不安全；标量循环每轮只能完成一位哲学家
+    for (int i = 0; i + 1 < t.num_phil; ++i) {
+        if (t.holder[t.left_fork_of[i]] == -1) t.holder[t.left_fork_of[i]] = i;
+    }
+}
+
+void fill_cycle(Table& t) {
+    for (int i = 0; i < t.num_phil; ++i) {
+        if (t.holder[t.left_fork_of[i]] == -1) t.holder[t.left_fork_of[i]] = i;
+    }
+}
+
+void fill_unsafe(Table& t, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick_phil(0, t.num_phil - 1);
+    for (int k = 0; k < 4 * t.num_phil; ++k) {
+        int i = pick_phil(rng);
+        int f = (rng() & 1) ? t.left_fork_of[i] : t.right_fork_of[i];
+        if (t.holder[f] == -1) t.holder[f] = i;
+    }
+}
+
+// 自适应重复次数，返回单次调用的平均纳秒数
+template<typename Func>
+double time_ns(Func&& func) {
+    using clock = std::chrono::steady_clock;
+    long long reps = 1;
+    while (true) {
+        auto begin = clock::now();
+        for (long long r = 0; r < reps; ++r) func();
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+        if (ns >= 2e8 || reps >= (1LL << 30)) return ns / reps;
+        reps *= (ns < 1e6) ? 16 : 2;
+    }
+}
+
+volatile bool sink;
+
+void run_case(const char* scenario, Table& t, bool run_scalar) {
+    std::vector<int> available(t.num_forks), need(t.num_phil);
+    std::vector<char> finished(t.num_phil);
+    BitsetSafetyChecker checker(t.left_fork_of, t.right_fork_of, t.num_forks);
+    for (int f = 0; f < t.num_forks; ++f) {
+        if (t.holder[f] != -1) checker.set_holder(f, t.holder[f]);
+    }
+
+    checker.set_kernel(BitsetSafetyChecker::Kernel::SCALAR);
+    // 参考结果由标量循环算出；超出规模上限时标量循环太慢，改以 64 位内核的结果作为 AVX2 内核的参考
+    bool expected = run_scalar ? scalar_banker_safe(t, available, need, finished) : checker.is_safe();
+    double scalar_ns = -1;
+    if (run_scalar) scalar_ns = time_ns([&] { sink = scalar_banker_safe(t, available, need, finished); });
+
+    if (checker.is_safe() != expected) {
+        std::fprintf(stderr, "mismatch: N=%d M=%d %s bitset-scalar\n", t.num_phil, t.num_forks, scenario);
+        std::exit(1);
+    }
+    double bits_ns = time_ns([&] { sink = checker.is_safe(); });
+
+    double avx2_ns = -1;
+    if (BitsetSafetyChecker::avx2_available()) {
+        checker.set_kernel(BitsetSafetyChecker::Kernel::AVX2);
+        if (checker.is_safe() != expected) {
+            std::fprintf(stderr, "mismatch: N=%d M=%d %s bitset-avx2\n", t.num_phil, t.num_forks, scenario);
+            std::exit(1);
+        }
+        avx2_ns = time_ns([&] { sink = checker.is_safe(); });
+    }
+
+    int held = 0;
+    for (int f = 0; f < t.num_forks; ++f) held += (t.holder[f] != -1);
+
+    std::string scalar_col = scalar_ns < 0 ? "-" : std::to_string(static_cast<long long>(scalar_ns));
+    std::string avx2_col = avx2_ns < 0 ? "-" : std::to_string(static_cast<long long>(avx2_ns));
+    std::printf("%8d  %8d  %-7s %-6s %7d  %14s  %14lld  %14s", t.num_phil, t.num_forks, scenario,
+                expected ? "yes" : "no", held, scalar_col.c_str(),
+                static_cast<long long>(bits_ns), avx2_col.c_str());
+    double best = (avx2_ns > 0 && avx2_ns < bits_ns) ? avx2_ns : bits_ns;
+    if (scalar_ns > 0) std::printf("  %8.1fx\n", scalar_ns / best);
+    else std::printf("  %9s\n", "-");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int max_n = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const int sizes[] = {5, 10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000};
+    // 链式最坏情况下标量循环为 O(N^2)，超过该规模时跳过以免运行过久
+    const int chain_scalar_limit = 20000;
+
+    std::printf("AVX2 kernel: %s\n", BitsetSafetyChecker::avx2_available() ? "available" : "unavailable");
+    std::printf("%8s  %8s  %-7s %-6s %7s  %14s  %14s  %14s  %9s\n", "N", "M", "state", "safe", "held",
+                "scalar ns", "bitset64 ns", "avx2 ns", "speedup");
+    for (int n : sizes) {
+        if (n > max_n) break;
+        const int fork_counts[] = {n, std::max(2, n * 2 / 3), n * 3 / 2};
+        for (int m : fork_counts) {
+            Table random_table = make_table(n, m);
+            fill_random(random_table, 12345u + n + m);
+            run_case("random", random_table, true);
+
+            Table chain_table = make_table(n, m);
+            fill_chain(chain_table);
+            run_case("chain", chain_table, n <= chain_scalar_limit);
+
+            Table cycle_table = make_table(n, m);
+            fill_cycle(cycle_table);
+            run_case("cycle", cycle_table, true);
+
+            Table unsafe_table = make_table(n, m);
+            fill_unsafe(unsafe_table, 54321u + n + m);
+            run_case("unsafe", unsafe_table, true);
+        }
+    }
+    return 0;
+}
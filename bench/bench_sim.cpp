@@ -0,0 +1,189 @@
+﻿#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 仿真吞吐量基准：直接链接 sim_engine，在 (N, M, 策略) 矩阵上运行线程模式（或任务模式）仿真，
+// 从事件日志中还原每位哲学家的时间线。先运行 WARMUP_SECONDS 让所有哲学家从同时开始思考的初始状态散开，
+// 之后的计时窗口内报告：
+//   meals/s       —— 计时窗口内的 EATING 次数 / 窗口时长
+//   wait p50/p99/max —— HUNGRY 到 EATING 的获取延迟（毫秒）
+//   hold p50/p99   —— 每把叉子从 ACQUIRE 到 RELEASE 的持有时长（毫秒）：进餐时的持有，
+//                     以及 try-lock 策略拿到左叉子后因右叉子失败而放下的约 10ms 的短暂持有
+//   cpu/meal      —— 窗口内进程 CPU 时间（用户态 + 内核态）/ 进餐次数（微秒，含本程序轮询事件的开销）
+//   lost          —— 事件队列溢出丢失的事件数，不为 0 时延迟统计不完整
+// 用法：bench_sim [每组计时窗口（秒），默认 5] [最大 N，默认 1000] [threads|tasks，默认 threads]
+// 思考与进餐各 500~1000ms，窗口应远长于一轮进餐，否则延迟与持有时长的样本很少
+// 哲学家线程的随机数种子不可指定，数值在多次运行之间只在统计意义上可重复
+
+namespace {
+
+const double WARMUP_SECONDS = 1.0;
+
+const char* strategy_name(int code) {
+    static const char* names[] = {"NONE", "BANKER", "ORDERED", "CHANDY_MISRA", "WAITER"};
+    return names[code];
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 进程累计 CPU 时间（秒）
+double process_cpu_seconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto to_100ns = [](const FILETIME& ft) {
+        return (static_cast<unsigned long long>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    return (to_100ns(kernel) + to_100ns(user)) * 1e-7;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// 已排序样本的 q 分位数（最近秩），没有样本时为 0
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// 按事件还原每位哲学家的时间线：同一哲学家的事件由同一线程（任务）按顺序写入，在队列中保持先后顺序
+class Timeline {
+public:
+    Timeline(int n_phil, int n_forks)
+        : num_phil(n_phil), num_forks(n_forks), hungry_since(n_phil, 0), acquired_at(2 * n_phil, 0),
+          window_begin(0), window_end(0), meals(0) {}
+
+    void set_window(uint64_t begin, uint64_t end) {
+        window_begin = begin;
+        window_end = end;
+    }
+
+    void consume(const std::vector<SimEvent>& events) {
+        for (const SimEvent& e : events) {
+            if (e.phil_id < 0) continue;
+            if (e.kind == EventKind::STATE && e.reason == EventReason::HUNGRY) {
+                hungry_since[e.phil_id] = e.timestamp_ns;
+            } else if (e.kind == EventKind::STATE && e.reason == EventReason::EATING) {
+                if (!in_window(e.timestamp_ns)) continue;
+                ++meals;
+                uint64_t since = hungry_since[e.phil_id];
+                if (since != 0) waits_ms.push_back((e.timestamp_ns - since) * 1e-6);
+                hungry_since[e.phil_id] = 0;
+            } else if (e.kind == EventKind::ACQUIRE) {
+                acquired_at[slot(e.phil_id, e.fork_id)] = e.timestamp_ns;
+            } else if (e.kind == EventKind::RELEASE) {
+                uint64_t& since = acquired_at[slot(e.phil_id, e.fork_id)];
+                if (since != 0 && in_window(e.timestamp_ns)) holds_ms.push_back((e.timestamp_ns - since) * 1e-6);
+                since = 0;
+            }
+        }
+    }
+
+    long long meal_count() const { return meals; }
+    std::vector<double>& waits() { return waits_ms; }
+    std::vector<double>& holds() { return holds_ms; }
+
+private:
+    // 哲学家的左叉子记在 2 * id，右叉子记在 2 * id + 1（与 Simulation 的比例映射一致）
+    size_t slot(int phil_id, int fork_id) const {
+        int left = static_cast<int>((static_cast<long long>(phil_id) * num_forks) / num_phil);
+        return 2 * static_cast<size_t>(phil_id) + (fork_id == left ? 0 : 1);
+    }
+    bool in_window(uint64_t ts) const { return ts >= window_begin && ts < window_end; }
+
+    int num_phil;
+    int num_forks;
+    std::vector<uint64_t> hungry_since;
+    std::vector<uint64_t> acquired_at;
+    std::vector<double> waits_ms;
+    std::vector<double> holds_ms;
+    uint64_t window_begin;
+    uint64_t window_end;
+    long long meals;
+};
+
+void run_case(int n, int m, int strategy, double seconds, bool tasks) {
+    Simulation sim(n, m);
+    sim.set_strategy(strategy);
+    Timeline timeline(n, m);
+
+    uint64_t begin = now_ns() + static_cast<uint64_t>(WARMUP_SECONDS * 1e9);
+    uint64_t end = begin + static_cast<uint64_t>(seconds * 1e9);
+    timeline.set_window(begin, end);
+    if (tasks) sim.start_tasks();
+    else sim.start();
+    // 定期取出事件，避免 N 较大时事件队列溢出
+    double cpu_begin = -1;
+    while (now_ns() < end) {
+        Sleep(5);
+        if (cpu_begin < 0 && now_ns() >= begin) cpu_begin = process_cpu_seconds();
+        timeline.consume(sim.poll_events());
+    }
+    double cpu_seconds = process_cpu_seconds() - cpu_begin;
+
+    // stop() 会逐行打印每位哲学家的统计，基准运行期间关闭 std::cout
+    std::cout.setstate(std::ios::failbit);
+    sim.stop();
+    std::cout.clear();
+    timeline.consume(sim.poll_events());
+    EventLogStats log_stats = sim.get_event_log_stats();
+
+    std::vector<double>& waits = timeline.waits();
+    std::vector<double>& holds = timeline.holds();
+    std::sort(waits.begin(), waits.end());
+    std::sort(holds.begin(), holds.end());
+    long long meals = timeline.meal_count();
+    double cpu_per_meal_us = meals > 0 ? cpu_seconds * 1e6 / meals : 0;
+
+    std::printf("%6d %6d  %-12s %9.1f  %8.1f %8.1f %8.1f  %8.1f %8.1f  %9.1f  %llu\n", n, m, strategy_name(strategy),
+                meals / seconds, percentile(waits, 0.5), percentile(waits, 0.99), waits.empty() ? 0.0 : waits.back(),
+                percentile(holds, 0.5), percentile(holds, 0.99), cpu_per_meal_us,
+                static_cast<unsigned long long>(log_stats.dropped + log_stats.overwritten));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = (argc > 1) ? std::atof(argv[1]) : 5.0;
+    int max_n = (argc > 2) ? std::atoi(argv[2]) : 1000;
+    bool tasks = (argc > 3) && std::strcmp(argv[3], "tasks") == 0;
+    const int sizes[] = {5, 20, 100, 500, 1000, 5000, 10000};
+    // 任务模式只支持 NONE / BANKER，其余策略会阻塞在叉子的互斥量上
+    int strategies = tasks ? 2 : 5;
+
+    std::printf("mode: %s, %.1f s warm-up + %.1f s per case\n", tasks ? "tasks" : "threads", WARMUP_SECONDS, seconds);
+    std::printf("%6s %6s  %-12s %9s  %8s %8s %8s  %8s %8s  %9s  %s\n", "N", "M", "strategy", "meals/s",
+                "wait p50", "wait p99", "wait max", "hold p50", "hold p99", "cpu/meal", "lost");
+    std::printf("%6s %6s  %-12s %9s  %8s %8s %8s  %8s %8s  %9s\n", "", "", "", "", "ms", "ms", "ms", "ms", "ms", "us");
+    for (int n : sizes) {
+        if (n > max_n) break;
+        // 叉子与哲学家一样多，以及叉子只有一半（比例映射下两位哲学家共享一把叉子的一侧）
+        for (int m : {n, std::max(2, n / 2)}) {
+            for (int strategy = 0; strategy < strategies; ++strategy) {
+                // CHANDY_MISRA 要求每把叉子至多两位使用者（N <= M）
+                if (strategy == 3 && m < n) continue;
+                run_case(n, m, strategy, seconds, tasks);
+            }
+        }
+    }
+    return 0;
+}
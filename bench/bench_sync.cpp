@@ -0,0 +1,185 @@
+﻿#include "win_sync.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 同步原语微基准：测量 win_sync 封装（WinMutex / WinSemaphore / WinThread）在各平台后端上的开销，
+// 并以 std::mutex / std::thread 作为对照，用于决定哲学家热路径上使用哪种原语。
+//   lock_unlock        —— 无竞争的加锁 + 解锁
+//   try_lock_success   —— 无竞争的 try_lock（成功）+ 解锁
+//   try_lock_fail      —— 另一线程持有锁时的 try_lock（失败）
+//   contended          —— threads 个线程轮流对同一把锁加锁 + 解锁，按总操作数平均
+//   ping_pong          —— 两个线程经一对信号量来回传递一次（往返延迟）
+//   start_join         —— 创建 threads 个空线程并全部 join，按线程数平均
+// 用法：bench_sync [csv|json，默认 csv]，结果写到标准输出（ns_per_op 为纳秒）
+
+namespace {
+
+struct Result {
+    std::string primitive;
+    std::string operation;
+    int threads;
+    long long ops;
+    double ns_per_op;
+};
+
+std::vector<Result> results;
+
+using bench_clock = std::chrono::steady_clock;
+
+double elapsed_ns(bench_clock::time_point begin) {
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - begin).count();
+}
+
+// 自适应重复次数（至少运行 0.2s），记录单次调用的平均纳秒数
+template<typename Func>
+void measure(const char* primitive, const char* operation, int threads, Func&& func) {
+    long long reps = 1;
+    while (true) {
+        auto begin = bench_clock::now();
+        for (long long r = 0; r < reps; ++r) func();
+        double ns = elapsed_ns(begin);
+        if (ns >= 2e8 || reps >= (1LL << 30)) {
+            results.push_back({primitive, operation, threads, reps, ns / reps});
+            return;
+        }
+        reps *= (ns < 1e6) ? 16 : 2;
+    }
+}
+
+template<typename Mutex>
+void bench_mutex(const char* primitive) {
+    Mutex mtx;
+    measure(primitive, "lock_unlock", 1, [&] { mtx.lock(); mtx.unlock(); });
+    measure(primitive, "try_lock_success", 1, [&] { if (mtx.try_lock()) mtx.unlock(); });
+
+    // WinMutex 可重入，失败路径必须由另一个线程持有锁
+    std::atomic<bool> held(false), release(false);
+    std::thread holder([&] {
+        mtx.lock();
+        held = true;
+        while (!release) std::this_thread::yield();
+        mtx.unlock();
+    });
+    while (!held) std::this_thread::yield();
+    measure(primitive, "try_lock_fail", 1, [&] { if (mtx.try_lock()) mtx.unlock(); });
+    release = true;
+    holder.join();
+}
+
+template<typename Mutex>
+void bench_contended(const char* primitive, int threads) {
+    Mutex mtx;
+    const long long per_thread = 200000 / threads + 1000;
+    long long counter = 0;
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            ready.fetch_add(1);
+            while (!go) std::this_thread::yield();
+            for (long long i = 0; i < per_thread; ++i) {
+                mtx.lock();
+                ++counter;
+                mtx.unlock();
+            }
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto begin = bench_clock::now();
+    go = true;
+    for (auto& w : workers) w.join();
+    double ns = elapsed_ns(begin);
+    long long ops = per_thread * threads;
+    if (counter != ops) {
+        std::fprintf(stderr, "%s: lost updates under contention (%lld of %lld)\n", primitive, counter, ops);
+        std::exit(1);
+    }
+    results.push_back({primitive, "contended", threads, ops, ns / ops});
+}
+
+void bench_ping_pong() {
+    WinSemaphore ping(0, 1), pong(0, 1);
+    std::atomic<bool> done(false);
+    WinThread partner;
+    partner.start([&] {
+        while (true) {
+            ping.wait();
+            if (done) break;
+            pong.post();
+        }
+    });
+    measure("WinSemaphore", "ping_pong", 2, [&] { ping.post(); pong.wait(); });
+    done = true;
+    ping.post();
+    partner.join();
+}
+
+void bench_win_thread(int threads) {
+    measure("WinThread", "start_join", threads, [&] {
+        std::vector<std::unique_ptr<WinThread>> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.push_back(std::make_unique<WinThread>());
+            pool.back()->start([] {});
+        }
+        for (auto& t : pool) t->join();
+    });
+    results.back().ns_per_op /= threads;
+}
+
+void bench_std_thread(int threads) {
+    measure("std::thread", "start_join", threads, [&] {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back([] {});
+        for (auto& t : pool) t.join();
+    });
+    results.back().ns_per_op /= threads;
+}
+
+void print_csv() {
+    std::printf("primitive,operation,threads,ops,ns_per_op\n");
+    for (const Result& r : results) {
+        std::printf("%s,%s,%d,%lld,%.1f\n", r.primitive.c_str(), r.operation.c_str(), r.threads, r.ops, r.ns_per_op);
+    }
+}
+
+void print_json() {
+    std::printf("[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::printf("  {\"primitive\": \"%s\", \"operation\": \"%s\", \"threads\": %d, \"ops\": %lld, \"ns_per_op\": %.1f}%s\n",
+                    r.primitive.c_str(), r.operation.c_str(), r.threads, r.ops, r.ns_per_op,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool json = (argc > 1) && std::strcmp(argv[1], "json") == 0;
+    const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+    bench_mutex<WinMutex>("WinMutex");
+    bench_mutex<std::mutex>("std::mutex");
+    for (int threads : thread_counts) {
+        bench_contended<WinMutex>("WinMutex", threads);
+        bench_contended<std::mutex>("std::mutex", threads);
+    }
+    bench_ping_pong();
+    for (int threads : thread_counts) {
+        bench_win_thread(threads);
+        bench_std_thread(threads);
+    }
+
+    if (json) print_json();
+    else print_csv();
+    return 0;
+}
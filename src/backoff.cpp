@@ -0,0 +1,133 @@
+﻿#include "backoff.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define SIM_CPU_RELAX() _mm_pause()
+#else
+#define SIM_CPU_RELAX() ((void)0)
+#endif
+
+namespace {
+
+const uint32_t CONTENTION_ONE = 1024;
+const int SPIN_ITERATIONS = 256;   // 一次 SPIN 动作的忙等次数（约数微秒）
+
+} // namespace
+
+BackoffPolicy::BackoffPolicy(int num_forks)
+    : kind(BackoffKind::FIXED), base_ms(5), max_ms(200), spin_limit(100), yield_limit(10),
+      contention(new std::atomic<uint32_t>[num_forks]), num_forks(num_forks),
+      spin_count(0), yield_count(0), sleep_count(0), sleep_ms_total(0) {
+    for (int f = 0; f < num_forks; ++f) contention[f].store(0, std::memory_order_relaxed);
+}
+
+void BackoffPolicy::configure(BackoffKind new_kind, int new_base_ms, int new_max_ms,
+                              int new_spin_limit, int new_yield_limit) {
+    if (new_base_ms < 1 || new_max_ms < new_base_ms) {
+        throw std::runtime_error("backoff requires 1 <= base_ms <= max_ms");
+    }
+    if (new_spin_limit < 0 || new_yield_limit < 0) {
+        throw std::runtime_error("backoff spin and yield limits must not be negative");
+    }
+    base_ms = new_base_ms;
+    max_ms = new_max_ms;
+    spin_limit = new_spin_limit;
+    yield_limit = new_yield_limit;
+    kind = new_kind;
+}
+
+DWORD BackoffPolicy::exponential(int attempt, std::mt19937& gen) const {
+    long long cap = max_ms.load(std::memory_order_relaxed);
+    long long d = base_ms.load(std::memory_order_relaxed);
+    for (int i = 0; i < attempt && d < cap; ++i) d *= 2;
+    d = std::min(d, cap);
+    // equal jitter：一半固定、一半随机，既打破对称又保证等待时间不会退化为 0
+    std::uniform_int_distribution<long long> jitter(d / 2, d);
+    return static_cast<DWORD>(jitter(gen));
+}
+
+BackoffStep BackoffPolicy::next(BackoffSite site, int attempt, int fork_id, std::mt19937& gen) {
+    BackoffStep step{BackoffStep::Action::SLEEP, 0};
+    switch (kind.load(std::memory_order_relaxed)) {
+    case BackoffKind::FIXED:
+        if (site == BackoffSite::RIGHT_FORK_FAILED) {
+            std::uniform_int_distribution<> dis(500, 1000);
+            step.ms = static_cast<DWORD>(dis(gen) / 10);
+        } else {
+            // 左叉子被占用时持有者释放它会提前唤醒我们，50ms 上限只是保底，防止错过唤醒时无限期等待
+            step.ms = 50;
+        }
+        break;
+
+    case BackoffKind::EXPONENTIAL:
+        step.ms = exponential(attempt, gen);
+        break;
+
+    case BackoffKind::ADAPTIVE: {
+        long long lo = base_ms.load(std::memory_order_relaxed);
+        long long hi = max_ms.load(std::memory_order_relaxed);
+        uint32_t c = contention[fork_id].load(std::memory_order_relaxed);
+        long long d = lo + (hi - lo) * c / CONTENTION_ONE;
+        std::uniform_int_distribution<long long> jitter(d * 3 / 4, d + d / 4);
+        step.ms = static_cast<DWORD>(std::max(1LL, jitter(gen)));
+        break;
+    }
+
+    case BackoffKind::SPIN_YIELD_SLEEP: {
+        int spins = spin_limit.load(std::memory_order_relaxed);
+        int yields = yield_limit.load(std::memory_order_relaxed);
+        if (attempt < spins) {
+            step.action = BackoffStep::Action::SPIN;
+        } else if (attempt < spins + yields) {
+            step.action = BackoffStep::Action::YIELD;
+        } else {
+            step.ms = exponential(attempt - spins - yields, gen);
+        }
+        break;
+    }
+    }
+
+    if (step.action == BackoffStep::Action::SLEEP) {
+        sleep_count.fetch_add(1, std::memory_order_relaxed);
+        sleep_ms_total.fetch_add(step.ms, std::memory_order_relaxed);
+    }
+    return step;
+}
+
+void BackoffPolicy::record(int fork_id, bool acquired) {
+    // 失败率的指数滑动平均（权重 1/8）；多个线程并发更新时偶尔丢失一次更新无关紧要
+    std::atomic<uint32_t>& c = contention[fork_id];
+    uint32_t v = c.load(std::memory_order_relaxed);
+    v = acquired ? v - v / 8 : v + (CONTENTION_ONE - v) / 8;
+    c.store(v, std::memory_order_relaxed);
+}
+
+void BackoffPolicy::spin_or_yield(const BackoffStep& step) {
+    if (step.action == BackoffStep::Action::SPIN) {
+        spin_count.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < SPIN_ITERATIONS; ++i) SIM_CPU_RELAX();
+    } else if (step.action == BackoffStep::Action::YIELD) {
+        yield_count.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+}
+
+void BackoffPolicy::spin_until(const std::atomic<int32_t>& word, int32_t value) {
+    spin_count.fetch_add(1, std::memory_order_relaxed);
+    for (int i = 0; i < SPIN_ITERATIONS && word.load(std::memory_order_relaxed) != value; ++i) SIM_CPU_RELAX();
+}
+
+BackoffStats BackoffPolicy::stats() const {
+    return {spin_count.load(), yield_count.load(), sleep_count.load(), sleep_ms_total.load()};
+}
+
+void BackoffPolicy::reset_stats() {
+    spin_count = 0;
+    yield_count = 0;
+    sleep_count = 0;
+    sleep_ms_total = 0;
+    for (int f = 0; f < num_forks; ++f) contention[f].store(0, std::memory_order_relaxed);
+}
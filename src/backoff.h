@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include "win_sync.h"
+
+// try-lock 获取路径上的退避策略：
+//   FIXED            右叉子失败后随机休眠 50~100ms；左叉子被占用或被拒绝时至多等 50ms（被占用的叉子释放时提前唤醒）
+//   EXPONENTIAL      第 k 次失败等待 min(max, base * 2^k)，取其后一半区间内的随机值（equal jitter）
+//   ADAPTIVE         按每把叉子最近的争用程度（失败率的指数滑动平均）在 [base, max] 之间线性取值，附带 ±25% 抖动
+//   SPIN_YIELD_SLEEP 前 spin_limit 次失败原地自旋后立即重试，随后 yield_limit 次让出时间片，之后按 EXPONENTIAL 休眠
+// 除右叉子失败后的退避外，休眠都在唤醒信号量上进行，所需叉子被释放时会提前结束
+enum class BackoffKind { FIXED, EXPONENTIAL, ADAPTIVE, SPIN_YIELD_SLEEP };
+
+// 退避发生的位置
+enum class BackoffSite {
+    RIGHT_FORK_FAILED,  // 拿到左叉子后右叉子失败，已放下左叉子
+    LEFT_FORK_BUSY,     // 左叉子被占用
+    LEFT_FORK_DENIED    // 左叉子空闲但被策略层拒绝
+};
+
+// 一次退避的动作：自旋、让出时间片或休眠 ms 毫秒
+struct BackoffStep {
+    enum class Action { SPIN, YIELD, SLEEP };
+    Action action;
+    DWORD ms;
+};
+
+// 退避计数器，用于比较不同策略对吞吐量与尾部等待时间的影响
+struct BackoffStats {
+    uint64_t spins;
+    uint64_t yields;
+    uint64_t sleeps;
+    uint64_t planned_sleep_ms;  // 计划的休眠总时长（被唤醒提前结束的部分也计入）
+};
+
+class BackoffPolicy {
+public:
+    explicit BackoffPolicy(int num_forks);
+
+    BackoffPolicy(const BackoffPolicy&) = delete;
+    BackoffPolicy& operator=(const BackoffPolicy&) = delete;
+
+    // 参数非法时抛出 std::runtime_error；运行中也可切换，各字段独立读取
+    void configure(BackoffKind kind, int base_ms, int max_ms, int spin_limit, int yield_limit);
+
+    // attempt 为本轮饥饿中已失败的次数（从 0 开始）
+    BackoffStep next(BackoffSite site, int attempt, int fork_id, std::mt19937& gen);
+    // 记录一次获取结果，供 ADAPTIVE 估计每把叉子的争用程度
+    void record(int fork_id, bool acquired);
+    // 执行自旋或让出时间片（休眠由调用方决定在何处等待）
+    void spin_or_yield(const BackoffStep& step);
+    // 一次 SPIN 动作，但只读 word 忙等，它等于 value（或忙等次数用完）即返回，期间不碰任何锁
+    void spin_until(const std::atomic<int32_t>& word, int32_t value);
+
+    BackoffStats stats() const;
+    void reset_stats();
+
+private:
+    DWORD exponential(int attempt, std::mt19937& gen) const;
+
+    std::atomic<BackoffKind> kind;
+    std::atomic<int> base_ms;
+    std::atomic<int> max_ms;
+    std::atomic<int> spin_limit;
+    std::atomic<int> yield_limit;
+
+    // 每把叉子的争用估计，定点数 0..1024（1024 表示最近几乎每次都失败）
+    std::unique_ptr<std::atomic<uint32_t>[]> contention;
+    int num_forks;
+
+    std::atomic<uint64_t> spin_count;
+    std::atomic<uint64_t> yield_count;
+    std::atomic<uint64_t> sleep_count;
+    std::atomic<uint64_t> sleep_ms_total;
+};
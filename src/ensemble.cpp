@@ -0,0 +1,68 @@
+﻿#include "ensemble.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+Ensemble::Ensemble(int num_workers) : workers(num_workers) {
+    if (workers <= 0) {
+        workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+int Ensemble::add(int num_philosophers, int num_forks, int strategy, unsigned int seed, double duration) {
+    if (num_philosophers < 1 || num_forks < 1) {
+        throw std::runtime_error("ensemble runs need at least one philosopher and one fork");
+    }
+    if (!(duration >= 0)) {
+        throw std::runtime_error("ensemble run duration must not be negative");
+    }
+    configs.push_back({num_philosophers, num_forks, strategy, seed, duration});
+    return size() - 1;
+}
+
+void Ensemble::clear() {
+    configs.clear();
+}
+
+std::vector<EnsembleResult> Ensemble::run() {
+    std::vector<EnsembleResult> results(configs.size());
+    std::vector<std::exception_ptr> errors(configs.size());
+    std::atomic<size_t> next(0);
+
+    // 每个工作线程循环领取下一个未运行的配置；各配置的 Simulation 互不共享状态，结果写入各自的槽位
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < configs.size(); i = next.fetch_add(1)) {
+            const EnsembleConfig& cfg = configs[i];
+            auto begin = std::chrono::steady_clock::now();
+            try {
+                Simulation sim(cfg.num_philosophers, cfg.num_forks);
+                sim.set_strategy(cfg.strategy);
+                results[i].stats = sim.run_virtual(cfg.duration, cfg.seed);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            results[i].config = cfg;
+            results[i].wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+    };
+
+    int count = std::min(workers, size());
+    std::vector<std::unique_ptr<WinThread>> pool;
+    for (int w = 0; w < count; ++w) {
+        auto t = std::make_unique<WinThread>();
+        t->start(worker);
+        pool.push_back(std::move(t));
+    }
+    for (auto& t : pool) {
+        if (t->joinable()) t->join();
+    }
+
+    for (const std::exception_ptr& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+    return results;
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <vector>
+#include "simulation.h"
+
+// 集合运行中的一个配置：每个配置对应一个独立的 Simulation，以虚拟时间模式（run_virtual）运行
+struct EnsembleConfig {
+    int num_philosophers;
+    int num_forks;
+    int strategy;        // 与 Simulation::set_strategy 相同的策略码（虚拟时间模式只支持 0 / 1）
+    unsigned int seed;
+    double duration;     // 虚拟时长（秒）
+};
+
+// 单个配置的运行结果，顺序与 add 的顺序一致
+struct EnsembleResult {
+    EnsembleConfig config;
+    SimStats stats;
+    double wall_time;    // 该配置实际耗费的墙钟时间（秒）
+};
+
+// 在固定大小的工作线程池上并发运行多个互不相关的仿真（参数扫描）。
+// 线程模式下每个哲学家占用一个系统线程，几十个配置同时运行就会耗尽线程与核数；
+// 虚拟时间模式的仿真是单线程的，因此 K 个配置只需要 num_workers 个线程，各工作线程从共享下标中领取下一个配置
+class Ensemble {
+public:
+    // num_workers <= 0 时使用硬件线程数
+    explicit Ensemble(int num_workers = 0);
+
+    // 参数非法时抛出 std::runtime_error；返回该配置的下标
+    int add(int num_philosophers, int num_forks, int strategy = 0, unsigned int seed = 0, double duration = 60.0);
+    void clear();
+    int size() const { return static_cast<int>(configs.size()); }
+    int num_workers() const { return workers; }
+
+    // 阻塞直到全部配置运行完毕；任一配置失败（例如策略只能在线程模式下使用）时，
+    // 等待其余配置结束后重新抛出第一个失败配置的异常
+    std::vector<EnsembleResult> run();
+
+private:
+    int workers;
+    std::vector<EnsembleConfig> configs;
+};
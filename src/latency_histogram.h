@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 高动态范围（HDR）延迟直方图：以微秒为单位，[0, 64) 逐个计数，此后每个 2 的幂区间等分为 32 个桶，
+// 任意值的相对误差不超过 1/32（约 3%），1us 到 71 分钟（2^32 us，更大的值计入最后一个桶）只需 896 个 32 位计数器。
+// 记录只做一次 relaxed fetch_add（最大值另做一次 CAS），不加锁，多个线程可同时记录；
+// 合并即逐桶相加，因此可以按哲学家分别记录、查询时再合并成全体的分布。
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t us) {
+        if (us > MAX_VALUE) us = MAX_VALUE;
+        counts[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = max_us.load(std::memory_order_relaxed);
+        while (us > seen && !max_us.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {}
+    }
+
+    // 把 other 的计数加到本直方图上（other 可能仍在被记录，合并结果是某一时刻附近的近似快照）
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < BUCKETS; ++b) {
+            uint32_t c = other.counts[b].load(std::memory_order_relaxed);
+            if (c != 0) counts[b].fetch_add(c, std::memory_order_relaxed);
+        }
+        uint64_t other_max = other.max_us.load(std::memory_order_relaxed);
+        uint64_t seen = max_us.load(std::memory_order_relaxed);
+        while (other_max > seen && !max_us.compare_exchange_weak(seen, other_max, std::memory_order_relaxed)) {}
+    }
+
+    void reset() {
+        for (int b = 0; b < BUCKETS; ++b) counts[b].store(0, std::memory_order_relaxed);
+        max_us.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (int b = 0; b < BUCKETS; ++b) total += counts[b].load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t max() const { return max_us.load(std::memory_order_relaxed); }
+
+    // q 分位数（0 < q <= 1）：返回该样本所在桶的上界（不超过最大值），没有样本时为 0
+    uint64_t percentile(double q) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = upper_bound_of(b);
+                uint64_t m = max();
+                return upper < m ? upper : m;
+            }
+        }
+        return max();
+    }
+
+private:
+    static const int LINEAR = 64;        // [0, 64) 每个值一个桶
+    static const int HALF_BITS = 5;      // 之后每个 2 的幂区间 32 个桶
+    static const int HALF = 1 << HALF_BITS;
+    static const uint64_t MAX_VALUE = 0xFFFFFFFFull;
+    static const int BUCKETS = LINEAR + (32 - 6) * HALF;
+
+    static int highest_bit(uint64_t v) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    static int bucket_of(uint64_t v) {
+        if (v < LINEAR) return static_cast<int>(v);
+        int msb = highest_bit(v);                  // >= 6
+        int shift = msb - HALF_BITS;
+        int top = static_cast<int>(v >> shift);    // [32, 64)
+        return LINEAR + (msb - 6) * HALF + (top - HALF);
+    }
+
+    static uint64_t upper_bound_of(int bucket) {
+        if (bucket < LINEAR) return static_cast<uint64_t>(bucket);
+        int k = bucket - LINEAR;
+        int msb = 6 + k / HALF;
+        uint64_t top = HALF + k % HALF;
+        int shift = msb - HALF_BITS;
+        return ((top + 1) << shift) - 1;
+    }
+
+    std::atomic<uint32_t> counts[BUCKETS];
+    std::atomic<uint64_t> max_us;
+};
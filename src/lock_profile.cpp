@@ -0,0 +1,48 @@
+﻿#include "win_sync.h"
+#include "lock_profile.h"
+#include <chrono>
+
+// WinMutex 的剖析路径：与平台无关，只在 set_profile 之后调用
+
+namespace {
+
+uint64_t profile_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+uint64_t WinMutex::lock_measured(LockProfile* p) {
+    // 先 try_lock 区分是否争用，只有争用时才读时钟计算等待时长
+    bool contended = !raw_try_lock();
+    uint64_t waited_ns = 0;
+    if (contended) {
+        uint64_t begin = profile_clock_ns();
+        raw_lock();
+        waited_ns = profile_clock_ns() - begin;
+    }
+    if (held_profile != nullptr) ++held_depth;
+    else if (p != nullptr) begin_hold(p, contended, waited_ns);
+    return waited_ns;
+}
+
+void WinMutex::begin_hold(LockProfile* p, bool contended, uint64_t waited_ns) {
+    held_profile = p;
+    held_depth = 1;
+    p->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended) {
+        p->contended.fetch_add(1, std::memory_order_relaxed);
+        p->wait_ns.fetch_add(waited_ns, std::memory_order_relaxed);
+    }
+    hold_since_ns = profile_clock_ns();
+}
+
+void WinMutex::end_hold() {
+    held_profile->hold_ns.fetch_add(profile_clock_ns() - hold_since_ns, std::memory_order_relaxed);
+    held_profile = nullptr;
+}
+
+void WinMutex::note_failed_try(LockProfile* p) {
+    p->failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 一把（或一组同名）WinMutex 的争用统计，由 WinMutex::set_profile 挂接。计数器以 relaxed 原子累加，
+// 同一个 LockProfile 可以被多个互斥量共享；只统计最外层的加锁，重入不重复计数
+struct LockProfile {
+    std::atomic<uint64_t> acquisitions;      // 成功获取（lock 与成功的 try_lock）
+    std::atomic<uint64_t> contended;         // 其中 lock 第一次尝试失败、需要等待的次数
+    std::atomic<uint64_t> failed_try_locks;  // try_lock 因锁被占用而失败的次数
+    std::atomic<uint64_t> wait_ns;           // 争用时等待的总时长
+    std::atomic<uint64_t> hold_ns;           // 从获取到最外层 unlock 的总持有时长
+
+    LockProfile() { reset(); }
+
+    LockProfile(const LockProfile&) = delete;
+    LockProfile& operator=(const LockProfile&) = delete;
+
+    void reset() {
+        acquisitions.store(0, std::memory_order_relaxed);
+        contended.store(0, std::memory_order_relaxed);
+        failed_try_locks.store(0, std::memory_order_relaxed);
+        wait_ns.store(0, std::memory_order_relaxed);
+        hold_ns.store(0, std::memory_order_relaxed);
+    }
+};
+
+// 按名字导出的统计快照（时长为毫秒），由 Simulation::get_lock_stats 返回
+struct LockStats {
+    std::string name;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t failed_try_locks;
+    double wait_ms;
+    double hold_ms;
+};
@@ -1,23 +1,220 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <cstddef>
 #include "simulation.h"
+#include "ensemble.h"
 
 namespace py = pybind11;
 
+namespace {
+
+// C++ 侧事件只保存紧凑记录，Python 访问 event_type / details 时才生成可读字符串
+const char* event_kind_name(EventKind kind) {
+    switch (kind) {
+    case EventKind::SYSTEM:   return "SYSTEM";
+    case EventKind::STATE:    return "STATE";
+    case EventKind::ACQUIRE:  return "ACQUIRE";
+    case EventKind::RELEASE:  return "RELEASE";
+    case EventKind::STATS:    return "STATS";
+    case EventKind::DEADLOCK: return "DEADLOCK";
+    }
+    return "UNKNOWN";
+}
+
+std::string event_details(const SimEvent& e) {
+    switch (e.reason) {
+    case EventReason::NONE:              return "";
+    case EventReason::THINKING:          return "THINKING";
+    case EventReason::HUNGRY:            return "HUNGRY";
+    case EventReason::EATING:            return "EATING";
+    case EventReason::LEFT_FORK:         return "Left Fork " + std::to_string(e.fork_id);
+    case EventReason::RIGHT_FORK:        return "Right Fork " + std::to_string(e.fork_id);
+    case EventReason::LEFT_FORK_BACKOFF: return "Left Fork " + std::to_string(e.fork_id) + " (Backoff)";
+    case EventReason::LEFT_FORK_DENIED:  return "Left Fork " + std::to_string(e.fork_id) + " (Permission Denied)";
+    case EventReason::SIM_STARTED:       return "Simulation started";
+    case EventReason::SIM_STOPPED:       return "Simulation stopped";
+    case EventReason::STRATEGY_CHANGED:  return "Strategy changed to " + std::to_string(e.value);
+    case EventReason::VIRTUAL_STARTED:   return "Virtual simulation started";
+    case EventReason::VIRTUAL_STOPPED:   return "Virtual simulation stopped";
+    case EventReason::EAT_COUNT:         return "Eaten: " + std::to_string(e.value);
+    case EventReason::MAX_WAIT:          return "MaxWait: " + std::to_string(e.value);
+    case EventReason::CYCLE:             return "Cycle detected involving Phil " + std::to_string(e.value);
+    case EventReason::CYCLE_MEMBER:      return "Waiting for Fork " + std::to_string(e.fork_id) +
+                                                " in cycle of " + std::to_string(e.value);
+    case EventReason::DETECTION_LATENCY: return "Cycle detected after " + std::to_string(e.value) + " us";
+    }
+    return "";
+}
+
+// SimEvent 对应的 NumPy 结构化 dtype（字段偏移与 C++ 布局一致，reserved 填充不导出）
+py::dtype sim_event_dtype() {
+    py::list names, formats, offsets;
+    auto field = [&](const char* name, const char* format, size_t offset) {
+        names.append(name);
+        formats.append(format);
+        offsets.append(offset);
+    };
+    field("timestamp_ns", "<u8", offsetof(SimEvent, timestamp_ns));
+    field("phil_id", "<i4", offsetof(SimEvent, phil_id));
+    field("fork_id", "<i4", offsetof(SimEvent, fork_id));
+    field("value", "<i4", offsetof(SimEvent, value));
+    field("kind", "u1", offsetof(SimEvent, kind));
+    field("reason", "u1", offsetof(SimEvent, reason));
+    return py::dtype(names, formats, offsets, sizeof(SimEvent));
+}
+
+// 取出全部事件并以结构化数组返回：数组直接引用 C++ 侧持有的缓冲区（由 capsule 负责释放），
+// 不为每个事件创建 Python 对象
+py::array poll_events_array(Simulation& sim) {
+    std::vector<SimEvent>* buffer;
+    {
+        // 取出事件期间不持有 GIL，构造数组时再重新获取
+        py::gil_scoped_release release;
+        buffer = new std::vector<SimEvent>(sim.poll_events());
+    }
+    py::capsule owner(buffer, [](void* p) { delete static_cast<std::vector<SimEvent>*>(p); });
+    return py::array(sim_event_dtype(),
+                     { static_cast<py::ssize_t>(buffer->size()) },
+                     { static_cast<py::ssize_t>(sizeof(SimEvent)) },
+                     buffer->data(), owner);
+}
+
+} // namespace
+
 PYBIND11_MODULE(sim_core, m) {
+    py::enum_<EventKind>(m, "EventKind")
+        .value("SYSTEM", EventKind::SYSTEM)
+        .value("STATE", EventKind::STATE)
+        .value("ACQUIRE", EventKind::ACQUIRE)
+        .value("RELEASE", EventKind::RELEASE)
+        .value("STATS", EventKind::STATS)
+        .value("DEADLOCK", EventKind::DEADLOCK);
+
+    py::enum_<EventReason>(m, "EventReason")
+        .value("NONE", EventReason::NONE)
+        .value("THINKING", EventReason::THINKING)
+        .value("HUNGRY", EventReason::HUNGRY)
+        .value("EATING", EventReason::EATING)
+        .value("LEFT_FORK", EventReason::LEFT_FORK)
+        .value("RIGHT_FORK", EventReason::RIGHT_FORK)
+        .value("LEFT_FORK_BACKOFF", EventReason::LEFT_FORK_BACKOFF)
+        .value("LEFT_FORK_DENIED", EventReason::LEFT_FORK_DENIED)
+        .value("SIM_STARTED", EventReason::SIM_STARTED)
+        .value("SIM_STOPPED", EventReason::SIM_STOPPED)
+        .value("STRATEGY_CHANGED", EventReason::STRATEGY_CHANGED)
+        .value("VIRTUAL_STARTED", EventReason::VIRTUAL_STARTED)
+        .value("VIRTUAL_STOPPED", EventReason::VIRTUAL_STOPPED)
+        .value("EAT_COUNT", EventReason::EAT_COUNT)
+        .value("MAX_WAIT", EventReason::MAX_WAIT)
+        .value("CYCLE", EventReason::CYCLE)
+        .value("CYCLE_MEMBER", EventReason::CYCLE_MEMBER)
+        .value("DETECTION_LATENCY", EventReason::DETECTION_LATENCY);
+
     py::class_<SimEvent>(m, "SimEvent")
-        .def_readonly("timestamp", &SimEvent::timestamp)
+        .def_property_readonly("timestamp", [](const SimEvent& e) { return e.timestamp_ns / 1e9; })
+        .def_readonly("timestamp_ns", &SimEvent::timestamp_ns)
         .def_readonly("phil_id", &SimEvent::phil_id)
-        .def_readonly("event_type", &SimEvent::event_type)
-        .def_readonly("details", &SimEvent::details);
+        .def_readonly("fork_id", &SimEvent::fork_id)
+        .def_readonly("value", &SimEvent::value)
+        .def_readonly("kind", &SimEvent::kind)
+        .def_readonly("reason", &SimEvent::reason)
+        .def_property_readonly("event_type", [](const SimEvent& e) { return std::string(event_kind_name(e.kind)); })
+        .def_property_readonly("details", &event_details);
+
+    py::class_<EventLogStats>(m, "EventLogStats")
+        .def_readonly("logged", &EventLogStats::logged)
+        .def_readonly("dropped", &EventLogStats::dropped)
+        .def_readonly("overwritten", &EventLogStats::overwritten)
+        .def_readonly("capacity", &EventLogStats::capacity);
+
+    py::class_<SimStats>(m, "SimStats")
+        .def_readonly("elapsed", &SimStats::elapsed)
+        .def_readonly("total_meals", &SimStats::total_meals)
+        .def_readonly("events_processed", &SimStats::events_processed)
+        .def_readonly("eat_counts", &SimStats::eat_counts)
+        .def_readonly("max_wait_counts", &SimStats::max_wait_counts);
+
+    py::class_<BackoffStats>(m, "BackoffStats")
+        .def_readonly("spins", &BackoffStats::spins)
+        .def_readonly("yields", &BackoffStats::yields)
+        .def_readonly("sleeps", &BackoffStats::sleeps)
+        .def_readonly("planned_sleep_ms", &BackoffStats::planned_sleep_ms);
+
+    py::class_<LatencyPercentiles>(m, "LatencyPercentiles")
+        .def_readonly("count", &LatencyPercentiles::count)
+        .def_readonly("p50", &LatencyPercentiles::p50)
+        .def_readonly("p99", &LatencyPercentiles::p99)
+        .def_readonly("p999", &LatencyPercentiles::p999)
+        .def_readonly("max", &LatencyPercentiles::max);
+
+    py::class_<LockStats>(m, "LockStats")
+        .def_readonly("name", &LockStats::name)
+        .def_readonly("acquisitions", &LockStats::acquisitions)
+        .def_readonly("contended", &LockStats::contended)
+        .def_readonly("failed_try_locks", &LockStats::failed_try_locks)
+        .def_readonly("wait_ms", &LockStats::wait_ms)
+        .def_readonly("hold_ms", &LockStats::hold_ms);
+
+    py::class_<SimSnapshot>(m, "SimSnapshot")
+        .def_readonly("version", &SimSnapshot::version)
+        .def_readonly("states", &SimSnapshot::states)
+        .def_readonly("fork_holders", &SimSnapshot::fork_holders);
+
+    // 可能阻塞或耗时的调用在执行 C++ 代码期间释放 GIL（返回值在重新获取 GIL 后再转换为 Python 对象），
+    // 使监控线程、Qt 事件循环以及同一解释器中的其他仿真不被阻塞
+    using release_gil = py::call_guard<py::gil_scoped_release>;
 
     py::class_<Simulation>(m, "Simulation")
         .def(py::init<int,int>())
-        .def("start", &Simulation::start)
-        .def("stop", &Simulation::stop)
+        .def("start", &Simulation::start, release_gil())
+        .def("stop", &Simulation::stop, release_gil())
         .def("set_strategy", &Simulation::set_strategy)
-        .def("get_states", &Simulation::get_states)
-        .def("get_resource_graph", &Simulation::get_resource_graph)
-        .def("poll_events", &Simulation::poll_events)
-        .def("detect_deadlock", &Simulation::detect_deadlock);
+        .def("set_backoff_policy", &Simulation::set_backoff_policy, py::arg("policy"),
+             py::arg("base_ms") = 5, py::arg("max_ms") = 200, py::arg("spin_limit") = 100, py::arg("yield_limit") = 10)
+        .def("get_backoff_stats", &Simulation::get_backoff_stats)
+        .def("set_timer_mode", &Simulation::set_timer_mode)
+        .def("set_latency_tracking", &Simulation::set_latency_tracking, release_gil())
+        .def("get_latency_percentiles", &Simulation::get_latency_percentiles,
+             py::arg("metric"), py::arg("phil_id") = -1, release_gil())
+        .def("set_lock_profiling", &Simulation::set_lock_profiling, release_gil())
+        .def("get_lock_stats", &Simulation::get_lock_stats, release_gil())
+        .def("set_trace_output", &Simulation::set_trace_output,
+             py::arg("path"), py::arg("max_events_per_thread") = 1000000, release_gil())
+        .def("get_states", &Simulation::get_states, release_gil())
+        .def("get_resource_graph", &Simulation::get_resource_graph, release_gil())
+        .def("get_snapshot", &Simulation::get_snapshot, release_gil())
+        .def("poll_events", &Simulation::poll_events, release_gil())
+        .def("poll_events_array", &poll_events_array)
+        .def("get_event_log_stats", &Simulation::get_event_log_stats)
+        .def("set_event_overflow_policy", &Simulation::set_event_overflow_policy)
+        .def("detect_deadlock", &Simulation::detect_deadlock, release_gil())
+        .def("start_deadlock_detector", &Simulation::start_deadlock_detector,
+             py::arg("interval_ms") = 10, release_gil())
+        .def("stop_deadlock_detector", &Simulation::stop_deadlock_detector, release_gil())
+        .def("deadlock_detector_running", &Simulation::deadlock_detector_running)
+        .def("run_virtual", &Simulation::run_virtual, py::arg("duration"), py::arg("seed") = 0, release_gil())
+        .def("start_tasks", &Simulation::start_tasks, py::arg("num_workers") = 0, release_gil())
+        .def("start_coroutines", &Simulation::start_coroutines, py::arg("num_workers") = 0, release_gil());
+
+    py::class_<EnsembleConfig>(m, "EnsembleConfig")
+        .def_readonly("num_philosophers", &EnsembleConfig::num_philosophers)
+        .def_readonly("num_forks", &EnsembleConfig::num_forks)
+        .def_readonly("strategy", &EnsembleConfig::strategy)
+        .def_readonly("seed", &EnsembleConfig::seed)
+        .def_readonly("duration", &EnsembleConfig::duration);
+
+    py::class_<EnsembleResult>(m, "EnsembleResult")
+        .def_readonly("config", &EnsembleResult::config)
+        .def_readonly("stats", &EnsembleResult::stats)
+        .def_readonly("wall_time", &EnsembleResult::wall_time);
+
+    py::class_<Ensemble>(m, "Ensemble")
+        .def(py::init<int>(), py::arg("num_workers") = 0)
+        .def("add", &Ensemble::add, py::arg("num_philosophers"), py::arg("num_forks"),
+             py::arg("strategy") = 0, py::arg("seed") = 0, py::arg("duration") = 60.0)
+        .def("clear", &Ensemble::clear)
+        .def("__len__", &Ensemble::size)
+        .def_property_readonly("num_workers", &Ensemble::num_workers)
+        .def("run", &Ensemble::run, release_gil());
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 有界无锁环形队列（Vyukov 有界队列）：每个槽位带序号，生产者/消费者各自用 CAS 推进位置，
+// 不需要任何互斥量。多生产者单消费者是主要用法，但结构本身对多消费者同样安全，
+// 因此“覆盖最旧记录”可以由生产者自己弹出队头实现。
+// T 必须是可平凡拷贝的定长记录，容量会向上取整为 2 的幂。
+template<typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t min_capacity)
+        : mask(round_up_pow2(min_capacity) - 1),
+          cells(new Cell[mask + 1]),
+          enqueue_pos(0), dequeue_pos(0),
+          pushed_count(0), dropped_count(0), overwritten_count(0) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // 入队；队列已满时返回 false（不计数，由调用方决定丢弃还是覆盖）
+    bool try_push(const T& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        pushed_count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 出队；队列为空时返回 false
+    bool try_pop(T& out) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        out = cell->data;
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 满时丢弃新记录，计入 dropped
+    bool push_or_drop(const T& value) {
+        if (try_push(value)) return true;
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 满时弹出并丢弃最旧的记录后重试，计入 overwritten（保留最近的 capacity 条）
+    void push_overwrite(const T& value) {
+        while (!try_push(value)) {
+            T oldest;
+            if (try_pop(oldest)) {
+                overwritten_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint64_t pushed() const { return pushed_count.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+    uint64_t overwritten() const { return overwritten_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    static size_t round_up_pow2(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    // 生产者与消费者的位置放在不同缓存行，避免相互失效
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;
+    alignas(64) std::atomic<uint64_t> pushed_count;
+    std::atomic<uint64_t> dropped_count;
+    std::atomic<uint64_t> overwritten_count;
+};
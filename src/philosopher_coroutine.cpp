@@ -0,0 +1,113 @@
+﻿#include "simulation.h"
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// 协程版哲学家（需要 C++20，以 SIM_ENABLE_COROUTINES 构建）：与 philosopher_thread 相同的顺序写法，
+// 但每个 Sleep 换成 co_await，挂起时只保留一个几十字节的协程帧，由任务模式的工作窃取执行器与时间轮恢复
+
+namespace {
+
+// 当前工作线程的随机数发生器：协程可能在任意工作线程上恢复，驱动方在每次恢复前设置
+thread_local std::mt19937* worker_gen = nullptr;
+
+// 哲学家协程的返回类型：创建后立即挂起；每次恢复执行到下一个 co_await，把要等待的毫秒数留在 promise 中
+class PhilosopherCoroutine {
+public:
+    struct promise_type {
+        long long delay_ms = 0;
+
+        PhilosopherCoroutine get_return_object() {
+            return PhilosopherCoroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit PhilosopherCoroutine(std::coroutine_handle<promise_type> h) : handle(h) {}
+    PhilosopherCoroutine(PhilosopherCoroutine&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    PhilosopherCoroutine(const PhilosopherCoroutine&) = delete;
+    PhilosopherCoroutine& operator=(const PhilosopherCoroutine&) = delete;
+    PhilosopherCoroutine& operator=(PhilosopherCoroutine&&) = delete;
+    ~PhilosopherCoroutine() {
+        if (handle) handle.destroy();
+    }
+
+    // 恢复到下一个 co_await，返回其等待时长（毫秒）
+    long long resume() {
+        handle.resume();
+        return handle.promise().delay_ms;
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// co_await sleep_for{ms}：挂起，由执行器在 ms 毫秒后（时间轮到期时）恢复
+struct sleep_for {
+    long long ms;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<PhilosopherCoroutine::promise_type> h) const noexcept {
+        h.promise().delay_ms = ms;
+    }
+    void await_resume() const noexcept {}
+};
+
+} // namespace
+
+// 持有全部哲学家的协程帧；随任务调度器的 step 函数一同销毁（stop() 时），挂起中的协程帧随之释放
+class CoroutinePhilosophers {
+public:
+    explicit CoroutinePhilosophers(Simulation& sim) : sim(sim) {
+        frames.reserve(sim.num_philosophers);
+        for (int i = 0; i < sim.num_philosophers; ++i) frames.push_back(run(i));
+    }
+
+    long long resume(int id, std::mt19937& gen) {
+        worker_gen = &gen;
+        return frames[id].resume();
+    }
+
+private:
+    PhilosopherCoroutine run(int id);
+
+    Simulation& sim;
+    std::vector<PhilosopherCoroutine> frames;
+};
+
+PhilosopherCoroutine CoroutinePhilosophers::run(int id) {
+    // 状态转换与 step_philosopher 共用（见 simulation.h），这里只决定它们之间的先后顺序
+    while (true) {
+        co_await sleep_for{sim.begin_thinking(id, sim.clock_ns(), *worker_gen)};
+        sim.become_hungry(id, sim.clock_ns());
+
+        // 等待叉子：每次尝试都经过 request_permission（反饥饿礼让与银行家检查），失败时按退避策略挂起一段时间再试
+        long long delay_ms = 0;
+        int attempt = 0;
+        while (true) {
+            if (sim.take_left_fork(id, sim.clock_ns(), attempt, *worker_gen, delay_ms)) {
+                co_await sleep_for{Simulation::SECOND_FORK_DELAY_MS};
+                if (sim.take_right_fork(id, sim.clock_ns(), attempt, *worker_gen, delay_ms)) break;
+            }
+            co_await sleep_for{delay_ms};  // 退避（右叉子失败时已放下左叉子）
+        }
+
+        co_await sleep_for{delay_ms};  // 进餐
+        sim.finish_eating(id, sim.clock_ns());
+    }
+}
+
+void Simulation::start_coroutines(int num_workers) {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (running) return;
+    enter_task_mode();
+    auto philosophers = std::make_shared<CoroutinePhilosophers>(*this);
+    launch_tasks(num_workers, [philosophers](int id, std::mt19937& gen) {
+        return philosophers->resume(id, gen);
+    });
+}
@@ -0,0 +1,187 @@
+﻿#include "safety_bitset.h"
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+BitsetSafetyChecker::BitsetSafetyChecker(const std::vector<int>& left_fork_of,
+                                         const std::vector<int>& right_fork_of, int num_forks)
+    : num_forks(num_forks),
+      left_fork_of(left_fork_of),
+      right_fork_of(right_fork_of),
+      holder(num_forks, -1),
+      fork_words((num_forks + 63) / 64),
+      base(fork_words, 0),
+      dep_right(fork_words, 0),
+      dep_left(fork_words, 0),
+      span_words((2 * static_cast<size_t>(num_forks) + 63) / 64),
+      pad_words(span_words + 1),
+      use_avx2(false) {
+    size_t buffer_words = pad_words + span_words + pad_words;
+    right_g.assign(buffer_words, 0);
+    right_p.assign(buffer_words, 0);
+    left_g.assign(buffer_words, 0);
+    left_p.assign(buffer_words, 0);
+    reset();
+    set_kernel(Kernel::AUTO);
+}
+
+void BitsetSafetyChecker::reset() {
+    std::fill(holder.begin(), holder.end(), -1);
+    std::fill(dep_right.begin(), dep_right.end(), 0);
+    std::fill(dep_left.begin(), dep_left.end(), 0);
+    // 所有叉子空闲：base 全为 1（最后一个字中超出 M 的位保持为 0）
+    std::fill(base.begin(), base.end(), ~0ULL);
+    if (num_forks % 64 != 0) base[fork_words - 1] = (1ULL << (num_forks % 64)) - 1;
+}
+
+bool BitsetSafetyChecker::avx2_available() {
+#ifdef SIM_HAVE_AVX2_KERNEL
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+void BitsetSafetyChecker::set_kernel(Kernel kernel) {
+    use_avx2 = (kernel != Kernel::SCALAR) && avx2_available();
+}
+
+void BitsetSafetyChecker::set_bit(std::vector<uint64_t>& bits, int index, bool value) {
+    uint64_t mask = 1ULL << (index % 64);
+    if (value) bits[index / 64] |= mask;
+    else bits[index / 64] &= ~mask;
+}
+
+void BitsetSafetyChecker::refresh(int f) {
+    int h = holder[f];
+    bool is_base = true, right = false, left = false;
+    if (h != -1) {
+        int g = (left_fork_of[h] == f) ? right_fork_of[h] : left_fork_of[h];
+        if (g != f && holder[g] != -1 && holder[g] != h) {
+            is_base = false;
+            if (g == (f + 1) % num_forks) right = true;
+            else left = true;
+        }
+    }
+    set_bit(base, f, is_base);
+    set_bit(dep_right, f, right);
+    set_bit(dep_left, f, left);
+}
+
+void BitsetSafetyChecker::set_holder(int fork_id, int phil_id) {
+    holder[fork_id] = phil_id;
+    // 受影响的只有该叉子本身，以及另一把叉子恰好是它的两侧叉子
+    refresh(fork_id);
+    refresh((fork_id + 1) % num_forks);
+    refresh((fork_id + num_forks - 1) % num_forks);
+}
+
+void BitsetSafetyChecker::load_doubled(const std::vector<uint64_t>& src, uint64_t* dst) {
+    // 把 M 位的环复制两份到 [0, M) 与 [M, 2M)，使环上长度不超过 M 的依赖链都能用线性移位处理
+    std::fill(dst, dst + span_words, 0);
+    std::copy(src.begin(), src.end(), dst);
+    size_t offset_words = num_forks / 64;
+    unsigned offset_bits = num_forks % 64;
+    for (size_t i = 0; i < fork_words; ++i) {
+        dst[offset_words + i] |= src[i] << offset_bits;
+        if (offset_bits != 0 && offset_words + i + 1 < span_words) {
+            dst[offset_words + i + 1] |= src[i] >> (64 - offset_bits);
+        }
+    }
+}
+
+bool BitsetSafetyChecker::evaluate() {
+    uint64_t* rg = right_g.data() + pad_words;
+    uint64_t* rp = right_p.data() + pad_words;
+    uint64_t* lg = left_g.data() + pad_words;
+    uint64_t* lp = left_p.data() + pad_words;
+    load_doubled(base, rg);
+    load_doubled(dep_right, rp);
+    load_doubled(base, lg);
+    load_doubled(dep_left, lp);
+
+    void (*step_down)(uint64_t*, uint64_t*, size_t, size_t) = &ks_step_down_scalar;
+    void (*step_up)(uint64_t*, uint64_t*, size_t, size_t) = &ks_step_up_scalar;
+#ifdef SIM_HAVE_AVX2_KERNEL
+    if (use_avx2) {
+        step_down = &ks_step_down_avx2;
+        step_up = &ks_step_up_avx2;
+    }
+#endif
+
+    // 依赖链长度不超过 M - 1，倍增步长覆盖到 >= M 即可
+    for (size_t shift = 1; shift < static_cast<size_t>(num_forks); shift <<= 1) {
+        step_down(rg, rp, span_words, shift);
+        step_up(lg, lp, span_words, shift);
+    }
+
+    // 叉子 f 最终可释放：右向链结果取第一份 [0, M)，左向链结果取第二份 [M, 2M)
+    size_t offset_words = num_forks / 64;
+    unsigned offset_bits = num_forks % 64;
+    for (size_t i = 0; i < fork_words; ++i) {
+        uint64_t left_bits = lg[offset_words + i] >> offset_bits;
+        if (offset_bits != 0) left_bits |= lg[offset_words + i + 1] << (64 - offset_bits);
+        uint64_t eventually_free = rg[i] | left_bits;
+        uint64_t mask = (i + 1 == fork_words && num_forks % 64 != 0)
+                            ? (1ULL << (num_forks % 64)) - 1 : ~0ULL;
+        if ((eventually_free & mask) != mask) return false;
+    }
+    return true;
+}
+
+bool BitsetSafetyChecker::is_safe() {
+    return evaluate();
+}
+
+bool BitsetSafetyChecker::is_safe_after_grant(int phil_id, int fork_id) {
+    if (holder[fork_id] != -1) return false;
+    set_holder(fork_id, phil_id);
+    bool safe = evaluate();
+    set_holder(fork_id, -1);
+    return safe;
+}
+
+void ks_step_down_scalar(uint64_t* g, uint64_t* p, size_t words, size_t shift) {
+    // 第 i 位读取第 i + shift 位：升序原地更新时读取的都是尚未写入的字
+    size_t q = shift / 64;
+    unsigned r = shift % 64;
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t gs = g[w + q] >> r;
+        uint64_t ps = p[w + q] >> r;
+        if (r != 0) {
+            gs |= g[w + q + 1] << (64 - r);
+            ps |= p[w + q + 1] << (64 - r);
+        }
+        g[w] |= p[w] & gs;
+        p[w] &= ps;
+    }
+}
+
+void ks_step_up_scalar(uint64_t* g, uint64_t* p, size_t words, size_t shift) {
+    // 第 i 位读取第 i - shift 位：降序原地更新
+    std::ptrdiff_t q = static_cast<std::ptrdiff_t>(shift / 64);
+    unsigned r = shift % 64;
+    for (std::ptrdiff_t w = static_cast<std::ptrdiff_t>(words) - 1; w >= 0; --w) {
+        uint64_t gs = g[w - q] << r;
+        uint64_t ps = p[w - q] << r;
+        if (r != 0) {
+            gs |= g[w - q - 1] >> (64 - r);
+            ps |= p[w - q - 1] >> (64 - r);
+        }
+        g[w] |= p[w] & gs;
+        p[w] &= ps;
+    }
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 位并行的银行家安全性检查内核。
+//
+// 每个哲学家恰好需要比例映射给出的一对相邻叉子 (l, l+1)，因此可以在“叉子空间”里判断安全性：
+// 叉子 f 被 h 持有时，f 最终能否被释放只取决于 h 的另一把叉子 g（g = f+1 或 f-1）：
+//   g 空闲或也在 h 手中 => h 可以完成，f 最终释放（base）
+//   否则 f 依赖 g 最终能否释放（dep_right: g = f+1，dep_left: g = f-1）
+// 所有叉子都最终可释放 <=> 所有哲学家都能完成 <=> 状态安全。
+// 依赖只沿相邻方向传播，相当于加法器中的进位链，用 Kogge-Stone 前缀算法以 64 位字
+// （或 AVX2 的 256 位）为单位并行求不动点，每步一次移位，共 O(log M) 步。
+class BitsetSafetyChecker {
+public:
+    enum class Kernel { AUTO, SCALAR, AVX2 };
+
+    BitsetSafetyChecker(const std::vector<int>& left_fork_of, const std::vector<int>& right_fork_of,
+                        int num_forks);
+
+    // 登记叉子持有者变化（phil_id = -1 表示释放），只更新 fork 及其两侧叉子所在的位
+    void set_holder(int fork_id, int phil_id);
+    void reset();
+
+    // 当前分配状态是否安全
+    bool is_safe();
+    // 假设把 fork_id 分给 phil_id 之后是否安全（叉子已被占用时返回 false）
+    bool is_safe_after_grant(int phil_id, int fork_id);
+
+    void set_kernel(Kernel kernel);
+    Kernel active_kernel() const { return use_avx2 ? Kernel::AVX2 : Kernel::SCALAR; }
+    static bool avx2_available();
+
+private:
+    void refresh(int fork_id);
+    void set_bit(std::vector<uint64_t>& bits, int index, bool value);
+    void load_doubled(const std::vector<uint64_t>& src, uint64_t* dst);
+    bool evaluate();
+
+    int num_forks;
+    std::vector<int> left_fork_of;
+    std::vector<int> right_fork_of;
+    std::vector<int> holder;
+
+    // 持久位集（每把叉子一位），随 set_holder 增量维护
+    size_t fork_words;
+    std::vector<uint64_t> base;
+    std::vector<uint64_t> dep_right;
+    std::vector<uint64_t> dep_left;
+
+    // 求不动点用的缓冲区：环展开成 2M 位的线性数组，前后各留一段零填充供移位读取越界部分
+    size_t span_words;
+    size_t pad_words;
+    std::vector<uint64_t> right_g, right_p, left_g, left_p;
+
+    bool use_avx2;
+};
+
+// Kogge-Stone 的一步：g |= p & (g 向低位移 shift 位)，p &= (p 向低位移 shift 位)。
+// “向低位移”即第 i 位读取第 i + shift 位（右侧依赖），up 版本读取第 i - shift 位（左侧依赖）。
+// data 前后需各有至少 shift / 64 + 1 个零填充字。
+void ks_step_down_scalar(uint64_t* g, uint64_t* p, size_t words, size_t shift);
+void ks_step_up_scalar(uint64_t* g, uint64_t* p, size_t words, size_t shift);
+#ifdef SIM_HAVE_AVX2_KERNEL
+void ks_step_down_avx2(uint64_t* g, uint64_t* p, size_t words, size_t shift);
+void ks_step_up_avx2(uint64_t* g, uint64_t* p, size_t words, size_t shift);
+#endif
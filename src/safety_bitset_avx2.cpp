@@ -0,0 +1,52 @@
+﻿#include "safety_bitset.h"
+#include <immintrin.h>
+
+// AVX2 版本的 Kogge-Stone 步：每次处理 4 个 64 位字（256 把叉子）。
+// 本文件单独以 AVX2 编译选项构建，是否调用由 BitsetSafetyChecker::avx2_available() 在运行时决定。
+// 移位计数 >= 64 时 _mm256_sll_epi64 / _mm256_srl_epi64 结果为 0，因此 r == 0 不需要分支。
+
+void ks_step_down_avx2(uint64_t* g, uint64_t* p, size_t words, size_t shift) {
+    size_t q = shift / 64;
+    __m128i rcount = _mm_cvtsi32_si128(static_cast<int>(shift % 64));
+    __m128i lcount = _mm_cvtsi32_si128(static_cast<int>(64 - shift % 64));
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        __m256i g0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + w + q));
+        __m256i g1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + w + q + 1));
+        __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w + q));
+        __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w + q + 1));
+        __m256i gs = _mm256_or_si256(_mm256_srl_epi64(g0, rcount), _mm256_sll_epi64(g1, lcount));
+        __m256i ps = _mm256_or_si256(_mm256_srl_epi64(p0, rcount), _mm256_sll_epi64(p1, lcount));
+        __m256i gw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + w));
+        __m256i pw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(g + w), _mm256_or_si256(gw, _mm256_and_si256(pw, gs)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + w), _mm256_and_si256(pw, ps));
+    }
+    if (w < words) ks_step_down_scalar(g + w, p + w, words - w, shift);
+}
+
+void ks_step_up_avx2(uint64_t* g, uint64_t* p, size_t words, size_t shift) {
+    std::ptrdiff_t q = static_cast<std::ptrdiff_t>(shift / 64);
+    __m128i lcount = _mm_cvtsi32_si128(static_cast<int>(shift % 64));
+    __m128i rcount = _mm_cvtsi32_si128(static_cast<int>(64 - shift % 64));
+    // 降序处理：先用标量补齐高位不足 4 个字的部分，再以 4 字为块向低位推进
+    std::ptrdiff_t w = static_cast<std::ptrdiff_t>(words);
+    std::ptrdiff_t tail = w % 4;
+    if (tail != 0) {
+        ks_step_up_scalar(g + (w - tail), p + (w - tail), static_cast<size_t>(tail), shift);
+        w -= tail;
+    }
+    for (; w >= 4; w -= 4) {
+        std::ptrdiff_t b = w - 4;
+        __m256i g0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + b - q));
+        __m256i g1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + b - q - 1));
+        __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b - q));
+        __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b - q - 1));
+        __m256i gs = _mm256_or_si256(_mm256_sll_epi64(g0, lcount), _mm256_srl_epi64(g1, rcount));
+        __m256i ps = _mm256_or_si256(_mm256_sll_epi64(p0, lcount), _mm256_srl_epi64(p1, rcount));
+        __m256i gw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + b));
+        __m256i pw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(g + b), _mm256_or_si256(gw, _mm256_and_si256(pw, gs)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + b), _mm256_and_si256(pw, ps));
+    }
+}
@@ -1,8 +1,13 @@
 ﻿#include "simulation.h"
+#include "strategy.h"
+#include "task_scheduler.h"
+#include "timer_service.h"
 #include <chrono>
 #include <random>
 #include <algorithm>
-#include <map>
+#include <queue>
+#include <cstdio>
+#include <stdexcept>
 #include <iostream>
 
 // Simulation 类实现了一个哲学家就餐问题的仿真。
@@ -13,195 +18,665 @@ Simulation::Simulation(int n_phil, int n_forks)
     : num_philosophers(n_phil), num_forks(n_forks), 
       running(false),  // 显式初始化为 false
       current_strategy(Strategy::NONE),  // 显式初始化策略
-      states(n_phil, State::THINKING), 
-      wait_counts(n_phil, 0),
-      eat_counts(n_phil, 0),
-      max_wait_counts(n_phil, 0) {
+      phils(new PhilosopherRecord[n_phil]),
+      timer_mode(TimerMode::SLEEP),
+      backoff(n_forks),
+      event_ring(EVENT_CAPACITY),
+      overflow_policy(OverflowPolicy::OVERWRITE_OLDEST),
+      task_mode(false),
+      latency_tracking(false),
+      virtual_clock(false),
+      virtual_now_ns(0),
+      trace_limit(0),
+      left_fork_of(n_phil),
+      right_fork_of(n_phil),
+      banker_need(n_phil, 2),
+      banker_state_safe(true),
+      visit_mark(n_phil, 0),
+      visit_epoch(0),
+      fork_users(n_forks),
+      wait_for(n_phil, -1),
+      wait_fork(n_phil, -1),
+      wait_since_ns(n_phil, 0),
+      wait_graph_version(0),
+      detect_edges(n_phil, -1),
+      detect_colour(n_phil, 0),
+      detector_running(false),
+      detector_wakeup(0, 1),
+      detector_interval_ms(10) {
     // 初始化叉子列表，每把叉子用一个互斥量保护（Fork 包含 mtx 和 holder 字段）
     for (int i = 0; i < n_forks; ++i) {
         forks.push_back(std::make_unique<Fork>());
     }
+    for (int i = 0; i < n_phil; ++i) {
+        wakeups.push_back(std::make_unique<WinSemaphore>(0, 1));
+    }
+    search_stack.reserve(n_phil);
+
+    // 将哲学家映射到叉子的策略：使用比例映射使得哲学家数和叉子数不一定相等时也合理分配
+    for (int i = 0; i < n_phil; ++i) {
+        left_fork_of[i] = static_cast<int>((static_cast<long long>(i) * n_forks) / n_phil);
+        right_fork_of[i] = (left_fork_of[i] + 1) % n_forks;
+    }
+    safety_bits = std::make_unique<BitsetSafetyChecker>(left_fork_of, right_fork_of, n_forks);
 
     // 计算竞争者：任何共享同一把叉子的哲学家都视为竞争者。
     // 这用于反饥饿策略：当某些竞争者等待过久时，优先让它们获得资源。
+    // 先按叉子分桶（每把叉子只被少数相邻哲学家需要），避免 O(N^2) 的两两比较；分桶结果也用于增量维护等待图
+    for (int i = 0; i < n_phil; ++i) {
+        fork_users[left_fork_of[i]].push_back(i);
+        if (right_fork_of[i] != left_fork_of[i]) fork_users[right_fork_of[i]].push_back(i);
+    }
     competitors.resize(n_phil);
-    auto get_forks = [&](int id) {
-        // 将哲学家映射到叉子的策略：使用比例映射使得哲学家数和叉子数不一定相等时也合理分配
-        int l = (static_cast<long long>(id) * n_forks) / n_phil;
-        int r = (l + 1) % n_forks;
-        return std::pair<int, int>{l, r};
-    };
-
     for (int i = 0; i < n_phil; ++i) {
-        auto [l1, r1] = get_forks(i);
-        for (int j = 0; j < n_phil; ++j) {
-            if (i == j) continue;
-            auto [l2, r2] = get_forks(j);
-            if (l1 == l2 || l1 == r2 || r1 == l2 || r1 == r2) {
-                competitors[i].push_back(j);
+        for (int f : {left_fork_of[i], right_fork_of[i]}) {
+            for (int j : fork_users[f]) {
+                if (j != i) competitors[i].push_back(j);
             }
         }
+        std::sort(competitors[i].begin(), competitors[i].end());
+        competitors[i].erase(std::unique(competitors[i].begin(), competitors[i].end()), competitors[i].end());
     }
+
+    // 策略对象按 Strategy 枚举值的顺序创建
+    strategies.push_back(std::make_unique<TryLockStrategy>(*this));
+    strategies.push_back(std::make_unique<BankerStrategy>(*this));
+    strategies.push_back(std::make_unique<OrderedStrategy>(*this));
+    strategies.push_back(std::make_unique<ChandyMisraStrategy>(*this));
+    strategies.push_back(std::make_unique<WaiterStrategy>(*this));
 }
 
 Simulation::~Simulation() { 
     // 析构时确保干净退出：停止所有线程并收集统计信息
+    stop_deadlock_detector();
     stop();
 }
 
 void Simulation::start() {
     // 启动仿真：为每个哲学家创建一个线程
+    WinLockGuard lifecycle(lifecycle_mutex);
     if (running) return;
     running = true;
+    reset_state_timestamps();
+    begin_trace(clock_ns());
+    if (timer_mode == TimerMode::WHEEL) {
+        timers = std::make_unique<TimerService>(num_philosophers);
+        timers->start();
+    }
     for (int i = 0; i < num_philosophers; ++i) {
         // 每个线程运行 philosopher_thread，代表一个并发执行的进程/线程
         auto t = std::make_unique<WinThread>();
         t->start([this, i]() { this->philosopher_thread(i); });
         threads.push_back(std::move(t));
     }
-    log_event(-1, "SYSTEM", "Simulation started");
+    log_event(-1, EventKind::SYSTEM, EventReason::SIM_STARTED);
 }
 
 void Simulation::stop() {
     // 停止仿真：先通知线程停止（running = false），然后 join 等待线程退出，避免悬挂线程。
+    WinLockGuard lifecycle(lifecycle_mutex);
     running = false;
+    // 没有运行中的线程（从未启动、已经停止或只运行过虚拟时间模式）时无需收集统计，
+    // 避免析构时重复输出，也使并发运行的大量仿真（Ensemble）不在控制台刷屏
+    if (threads.empty() && !tasks) return;
+    bool threaded = !threads.empty();
+    if (tasks) {
+        // 任务模式：工作线程执行完当前一步后退出，再归还仍登记在哲学家名下的叉子（任务模式不锁 Fork::mtx）
+        tasks->stop();
+        tasks.reset();
+        for (int f = 0; f < num_forks; ++f) {
+            int holder = forks[f]->holder;
+            if (holder != -1) release_fork(holder, f, false);
+        }
+        WinLockGuard lock(state_mutex);
+        task_mode = false;
+    }
+    // 提前结束所有定时等待，再唤醒所有在等待叉子释放的哲学家，使其立即看到 running == false
+    if (timers) timers->stop();
+    for (auto& w : wakeups) w->post();
     for (auto& t : threads) {
         if (t->joinable()) t->join();
     }
     threads.clear();
+    timers.reset();
 
     // 收集并记录统计信息
     for (int i = 0; i < num_philosophers; ++i) {
-        if (states[i] == State::HUNGRY && wait_counts[i] > max_wait_counts[i]) {
-             max_wait_counts[i] = wait_counts[i];
+        PhilosopherRecord& p = phils[i];
+        if (p.state.load() == State::HUNGRY && p.wait_count.load() > p.max_wait_count.load()) {
+             p.max_wait_count.store(p.wait_count.load());
+        }
+        log_event(i, EventKind::STATS, EventReason::EAT_COUNT, -1, p.eat_count.load());
+        log_event(i, EventKind::STATS, EventReason::MAX_WAIT, -1, p.max_wait_count.load());
+        // 任务模式面向大规模 N，不逐行输出
+        if (threaded) {
+            std::cout << "Phil " << i << " Eaten: " << p.eat_count.load()
+                      << ", MaxWait: " << p.max_wait_count.load() << std::endl;
         }
-        std::string details = "Eaten: " + std::to_string(eat_counts[i]) + 
-                              ", MaxWait: " + std::to_string(max_wait_counts[i]);
-        log_event(i, "STATS", details);
-        std::cout << "Phil " << i << " " << details << std::endl;
     }
+    finish_trace(clock_ns());
 
-    log_event(-1, "SYSTEM", "Simulation stopped");
+    // 线程与任务都已退出、叉子均已归还，停在 HUNGRY / EATING 的记录一律归为 THINKING，
+    // 快照与等待图不再显示停止前的状态（放在补全时间线之后，最后一段区间仍按原状态记录）
+    for (int i = 0; i < num_philosophers; ++i) {
+        PhilosopherRecord& p = phils[i];
+        if (p.state.load() == State::THINKING) continue;
+        p.state.store(State::THINKING, std::memory_order_release);
+        snapshot.publish(p.published_state, static_cast<int>(State::THINKING));
+    }
+    wait_graph_version.fetch_add(1, std::memory_order_release);
+
+    log_event(-1, EventKind::SYSTEM, EventReason::SIM_STOPPED);
 }
 
 void Simulation::set_strategy(int strategy_code) {
     // 修改资源分配策略需要对共享状态上锁，避免竞态条件
     WinLockGuard lock(state_mutex);
-    if (strategy_code == 1) current_strategy = Strategy::BANKER;
-    else current_strategy = Strategy::NONE;
-    log_event(-1, "SYSTEM", "Strategy changed to " + std::to_string(strategy_code));
+    Strategy next = Strategy::NONE;
+    if (strategy_code == 1) next = Strategy::BANKER;
+    else if (strategy_code == 2) next = Strategy::ORDERED;
+    else if (strategy_code == 3) next = Strategy::CHANDY_MISRA;
+    else if (strategy_code == 4) next = Strategy::WAITER;
+    if (task_mode && strategies[static_cast<int>(next)]->threaded_only()) {
+        throw std::runtime_error("this strategy blocks on fork mutexes and is not available in task mode");
+    }
+    if (next == Strategy::CHANDY_MISRA) {
+        auto& cm = static_cast<ChandyMisraStrategy&>(*strategies[static_cast<int>(Strategy::CHANDY_MISRA)]);
+        if (!cm.supported()) {
+            throw std::runtime_error("Chandy-Misra requires every fork to be shared by at most two philosophers (N <= M)");
+        }
+        // 每次从其他策略切换过来都重建协议状态，不沿用上次留下的叉子归属与信箱中的消息
+        if (current_strategy != Strategy::CHANDY_MISRA) cm.prepare();
+    }
+    current_strategy = next;
+    // 两把都没拿到时等待哪一把取决于策略（ORDERED 先拿编号较小的一把），切换后重算全部等待边
+    update_all_wait_edges();
+    log_event(-1, EventKind::SYSTEM, EventReason::STRATEGY_CHANGED, -1, strategy_code);
+}
+
+void Simulation::set_backoff_policy(int policy_code, int base_ms, int max_ms, int spin_limit, int yield_limit) {
+    BackoffKind kind = BackoffKind::FIXED;
+    if (policy_code == 1) kind = BackoffKind::EXPONENTIAL;
+    else if (policy_code == 2) kind = BackoffKind::ADAPTIVE;
+    else if (policy_code == 3) kind = BackoffKind::SPIN_YIELD_SLEEP;
+    backoff.configure(kind, base_ms, max_ms, spin_limit, yield_limit);
+    backoff.reset_stats();
+}
+
+BackoffStats Simulation::get_backoff_stats() const {
+    return backoff.stats();
 }
 
-void Simulation::log_event(int phil_id, const std::string& type, const std::string& details) {
-    // 事件记录受 event_mutex 保护，避免多线程并发写入导致数据不一致
-    WinLockGuard lock(event_mutex);
-    auto now = std::chrono::system_clock::now().time_since_epoch();
-    double ts = std::chrono::duration<double>(now).count();
-    event_queue.push_back({ts, phil_id, type, details});
-    // 限制事件队列长度，防止无限增长导致内存问题
-    if (event_queue.size() > 5000) event_queue.pop_front();
+void Simulation::set_timer_mode(int mode_code) {
+    timer_mode = (mode_code == 1) ? TimerMode::WHEEL : TimerMode::SLEEP;
+}
+
+void Simulation::timed_sleep(int phil_id, DWORD ms) {
+    if (timers) timers->sleep(phil_id, ms);
+    else Sleep(ms);
+}
+
+bool Simulation::timed_wait(int phil_id, WinSemaphore& sem, DWORD ms) {
+    if (timers) return timers->wait(phil_id, sem, ms);
+    return sem.try_wait(ms);
+}
+
+namespace {
+
+uint64_t monotonic_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+// 在出度至多为 1 的等待图中找出所有环：从每个未染色的起点沿唯一出边前进，以本次行走的编号染色。
+// 走到本次染过的节点即发现一个环（回调参数为环上的一个节点），走到更早染过的节点或没有出边则停止。
+// 每个节点只被染色一次，总复杂度 O(N)
+template<typename OnCycle>
+void for_each_wait_cycle(const std::vector<int>& wait_for, std::vector<int>& colour, OnCycle&& on_cycle) {
+    std::fill(colour.begin(), colour.end(), 0);
+    for (int start = 0; start < static_cast<int>(wait_for.size()); ++start) {
+        if (colour[start] != 0) continue;
+        int walk = start + 1;
+        int x = start;
+        while (x != -1 && colour[x] == 0) {
+            colour[x] = walk;
+            x = wait_for[x];
+        }
+        if (x != -1 && colour[x] == walk) on_cycle(x);
+    }
+}
+
+} // namespace
+
+void Simulation::set_latency_tracking(bool enabled) {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (enabled) {
+        if (!latency) latency.reset(new PhilosopherLatency[num_philosophers]);
+        for (int i = 0; i < num_philosophers; ++i) latency[i].reset();
+        reset_state_timestamps();
+    }
+    // release 与记录方的 acquire 配对：看到 true 的线程一定也看到已分配的直方图
+    latency_tracking.store(enabled, std::memory_order_release);
+}
+
+LatencyPercentiles Simulation::get_latency_percentiles(int metric, int phil_id) const {
+    if (metric < 0 || metric > static_cast<int>(LatencyMetric::EAT)) {
+        throw std::runtime_error("latency metric must be 0 (WAIT), 1 (HOLD), 2 (THINK) or 3 (EAT)");
+    }
+    if (phil_id < -1 || phil_id >= num_philosophers) {
+        throw std::runtime_error("phil_id must be -1 (all philosophers) or a valid philosopher index");
+    }
+    LatencyPercentiles result{};
+    if (!latency) return result;
+
+    auto pick = [metric](PhilosopherLatency& l) -> LatencyHistogram& {
+        switch (static_cast<LatencyMetric>(metric)) {
+        case LatencyMetric::WAIT:  return l.wait;
+        case LatencyMetric::HOLD:  return l.hold;
+        case LatencyMetric::THINK: return l.think;
+        case LatencyMetric::EAT:   break;
+        }
+        return l.eat;
+    };
+    // 各哲学家的直方图逐桶相加（记录仍在进行时得到的是近似同一时刻的分布）
+    auto merged = std::make_unique<LatencyHistogram>();
+    int first = (phil_id == -1) ? 0 : phil_id;
+    int last = (phil_id == -1) ? num_philosophers : phil_id + 1;
+    for (int i = first; i < last; ++i) merged->merge(pick(latency[i]));
+
+    result.count = merged->count();
+    result.p50 = merged->percentile(0.5) / 1000.0;
+    result.p99 = merged->percentile(0.99) / 1000.0;
+    result.p999 = merged->percentile(0.999) / 1000.0;
+    result.max = merged->max() / 1000.0;
+    return result;
+}
+
+void Simulation::set_lock_profiling(bool enabled) {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (enabled && !lock_profiles) lock_profiles.reset(new LockProfile[2 + num_forks]);
+    if (enabled) {
+        for (int i = 0; i < 2 + num_forks; ++i) lock_profiles[i].reset();
+    }
+    // 正在持有的锁按加锁时的设置结算，因此可以在仿真运行时切换
+    state_mutex.set_profile(enabled ? &lock_profiles[0] : nullptr);
+    lifecycle_mutex.set_profile(enabled ? &lock_profiles[1] : nullptr);
+    for (int f = 0; f < num_forks; ++f) forks[f]->mtx.set_profile(enabled ? &lock_profiles[2 + f] : nullptr);
+}
+
+std::vector<LockStats> Simulation::get_lock_stats() const {
+    std::vector<LockStats> result;
+    if (!lock_profiles) return result;
+    auto snapshot_of = [](const std::string& name, const LockProfile& p) {
+        return LockStats{name,
+                         p.acquisitions.load(std::memory_order_relaxed),
+                         p.contended.load(std::memory_order_relaxed),
+                         p.failed_try_locks.load(std::memory_order_relaxed),
+                         p.wait_ns.load(std::memory_order_relaxed) / 1e6,
+                         p.hold_ns.load(std::memory_order_relaxed) / 1e6};
+    };
+    result.push_back(snapshot_of("state_mutex", lock_profiles[0]));
+    result.push_back(snapshot_of("lifecycle_mutex", lock_profiles[1]));
+
+    LockStats total{"forks", 0, 0, 0, 0.0, 0.0};
+    std::vector<LockStats> per_fork;
+    for (int f = 0; f < num_forks; ++f) {
+        LockStats s = snapshot_of("fork[" + std::to_string(f) + "]", lock_profiles[2 + f]);
+        total.acquisitions += s.acquisitions;
+        total.contended += s.contended;
+        total.failed_try_locks += s.failed_try_locks;
+        total.wait_ms += s.wait_ms;
+        total.hold_ms += s.hold_ms;
+        // 任务模式、虚拟时间模式不锁 Fork::mtx，百万量级的叉子也不会全部出现在结果中
+        if (s.acquisitions != 0 || s.failed_try_locks != 0) per_fork.push_back(std::move(s));
+    }
+    result.push_back(total);
+    result.insert(result.end(), per_fork.begin(), per_fork.end());
+    return result;
+}
+
+void Simulation::set_trace_output(const std::string& path, int max_events_per_thread) {
+    if (max_events_per_thread <= 0) throw std::runtime_error("max_events_per_thread must be positive");
+    if (!path.empty()) {
+        // 提前确认文件可写：写出发生在 stop() 中（析构时也会调用），那时已无法向调用方报告错误。
+        // 以追加方式打开，不会清空已有的同名文件（例如上一次的追踪），它要到写出时才被覆盖
+        FILE* probe = std::fopen(path.c_str(), "a");
+        if (!probe) throw std::runtime_error("cannot open trace output file: " + path);
+        std::fclose(probe);
+    }
+    WinLockGuard lifecycle(lifecycle_mutex);
+    trace_path = path;
+    trace_limit = static_cast<size_t>(max_events_per_thread);
+}
+
+void Simulation::begin_trace(uint64_t origin_ns) {
+    if (trace_path.empty()) return;
+    trace = std::make_unique<TraceRecorder>(origin_ns, trace_limit);
+}
+
+void Simulation::finish_trace(uint64_t end_ns) {
+    if (!trace) return;
+    // 所有记录线程已经停止：补上每位哲学家仍未结束的状态区间，使时间线延伸到停止时刻
+    for (int i = 0; i < num_philosophers; ++i) {
+        PhilosopherRecord& p = phils[i];
+        uint64_t since = p.state_since_ns.load(std::memory_order_relaxed);
+        if (since == SIM_NO_TIMESTAMP || end_ns < since) continue;
+        trace->span(i, static_cast<TraceName>(p.state.load(std::memory_order_relaxed)), since, end_ns - since);
+    }
+    if (!trace->write(trace_path, num_philosophers)) {
+        std::cerr << "failed to write trace file " << trace_path << std::endl;
+    }
+    trace.reset();
+}
+
+void Simulation::lock_traced(WinMutex& m, int phil_id, TraceName name) {
+    if (!trace) {
+        m.lock();
+        return;
+    }
+    // 等待时长由互斥量在同一次获取中测量：未争用时不读时钟，同时启用锁剖析时也只计为一次获取
+    uint64_t waited_ns = m.lock_and_measure();
+    if (waited_ns == 0) return;
+    uint64_t end = clock_ns();
+    trace->span(phil_id, name, end - waited_ns, waited_ns);
+}
+
+uint64_t Simulation::clock_ns() const {
+    return virtual_clock ? virtual_now_ns : monotonic_ns();
+}
+
+void Simulation::record_state_change(int phil_id, State next) {
+    // 状态只由哲学家自己的线程（任务）切换，since 与当前状态不会被并发修改
+    PhilosopherRecord& p = phils[phil_id];
+    uint64_t now = clock_ns();
+    uint64_t since = p.state_since_ns.load(std::memory_order_relaxed);
+    p.state_since_ns.store(now, std::memory_order_relaxed);
+    if (since == SIM_NO_TIMESTAMP || now < since) return;
+
+    State prev = p.state.load(std::memory_order_relaxed);
+    if (trace) trace->span(phil_id, static_cast<TraceName>(prev), since, now - since);
+    if (!latency_tracking.load(std::memory_order_acquire)) return;
+
+    uint64_t us = (now - since) / 1000;
+    PhilosopherLatency& l = latency[phil_id];
+    if (prev == State::THINKING && next == State::HUNGRY) l.think.record(us);
+    else if (prev == State::HUNGRY && next == State::EATING) l.wait.record(us);
+    else if (prev == State::EATING && next == State::THINKING) l.eat.record(us);
+}
+
+void Simulation::reset_state_timestamps() {
+    // 每次开始运行前清除上一次运行留下的时刻，避免把两次运行之间的间隔计入直方图或时间线
+    for (int i = 0; i < num_philosophers; ++i) phils[i].state_since_ns.store(SIM_NO_TIMESTAMP, std::memory_order_relaxed);
+    WinLockGuard lock(state_mutex);
+    for (auto& f : forks) f->acquired_ns = SIM_NO_TIMESTAMP;
+}
+
+void Simulation::log_event(int phil_id, EventKind kind, EventReason reason, int fork_id, int value) {
+    log_event_at(monotonic_ns(), phil_id, kind, reason, fork_id, value);
+}
+
+void Simulation::log_event_at(uint64_t ts_ns, int phil_id, EventKind kind, EventReason reason,
+                              int fork_id, int value) {
+    // 事件以定长 POD 记录写入无锁环形队列，多个哲学家线程并发写入时互不阻塞，也不分配内存。
+    // 队列有界，满时按溢出策略处理并计数，防止无限增长导致内存问题
+    SimEvent rec;
+    rec.timestamp_ns = ts_ns;
+    rec.phil_id = phil_id;
+    rec.fork_id = fork_id;
+    rec.value = value;
+    rec.kind = kind;
+    rec.reason = reason;
+    rec.reserved = 0;
+
+    if (overflow_policy.load(std::memory_order_relaxed) == OverflowPolicy::DROP_NEWEST) {
+        event_ring.push_or_drop(rec);
+    } else {
+        event_ring.push_overwrite(rec);
+    }
 }
 
 std::vector<SimEvent> Simulation::poll_events() {
-    // 从事件队列中取出所有事件并清空队列，使用锁来保证一致性
-    WinLockGuard lock(event_mutex);
-    std::vector<SimEvent> events(event_queue.begin(), event_queue.end());
-    event_queue.clear();
+    // 单消费者：取出队列中当前所有事件
+    std::vector<SimEvent> events;
+    SimEvent rec;
+    while (event_ring.try_pop(rec)) {
+        events.push_back(rec);
+    }
     return events;
 }
 
+EventLogStats Simulation::get_event_log_stats() const {
+    return {event_ring.pushed(), event_ring.dropped(), event_ring.overwritten(), event_ring.capacity()};
+}
+
+void Simulation::set_event_overflow_policy(int policy_code) {
+    overflow_policy = (policy_code == 1) ? OverflowPolicy::DROP_NEWEST : OverflowPolicy::OVERWRITE_OLDEST;
+}
+
 bool Simulation::is_safe_state(int phil_id, int fork_id) {
-    // 基于银行家算法（Banker's Algorithm）的安全性检查的简化实现：
-    // available[] 表示每个资源（叉子）当前是否可用（1 = 可用, 0 = 不可用）
-    // need[] 表示每个哲学家还需要多少个资源才能完成（这里最大需要 2 把叉子）
-    // 该函数用于在允许某哲学家占用某把叉子之前，判断系统是否仍然处于安全状态，
-    // 以避免引入可能导致死锁的分配。
-    std::vector<int> available(num_forks, 1);
-    std::vector<int> need(num_philosophers, 2); 
-
-    for (int i = 0; i < num_forks; ++i) {
-        int holder = forks[i]->holder;
-        if (holder != -1) {
-            // 如果叉子被占用，则该资源不可用，并且占用该叉子的哲学家需要的资源数减一
-            available[i] = 0;
-            need[holder]--;
-        }
-    }
+    // 基于银行家算法（Banker's Algorithm）的安全性检查（调用方持有 state_mutex）：
+    // 每个哲学家最多需要 2 把叉子，且恰好是比例映射给出的左右两把。
+    // 把“哲学家 i 所需的叉子被 j 持有”看作等待边 i -> j（每人至多两条出边），
+    // 则“存在一个让所有人依次完成的顺序”等价于等待图中没有环。
+    //
+    // 增量检查：available / need 作为持久状态随获取与释放更新，当前状态已知安全时，
+    // 假设把 fork_id 分给 phil_id 只会新增“需要 fork_id 的哲学家 -> phil_id”这些边，
+    // 因此新环必然经过 phil_id。只需从 phil_id 出发沿等待边搜索，看能否到达某个需要
+    // fork_id 的哲学家即可，复杂度为 O(可达哲学家数) <= O(N)，且不分配内存。
 
     // 如果要请求的叉子当前不可用，则肯定不能分配
-    if (available[fork_id] == 0) return false; 
+    if (forks[fork_id]->holder != -1) return false;
 
-    // 试假设将 fork_id 分配给 phil_id，然后检查系统是否可以顺利完成所有人的需求
-    available[fork_id] = 0;
-    need[phil_id]--;
+    // 之前有未经检查的分配（如 NONE 策略下），先用位并行内核对当前状态做一次完整检查
+    if (!banker_state_safe) {
+        if (!safety_bits->is_safe()) return false;
+        banker_state_safe = true;
+    }
 
-    std::vector<bool> finish(num_philosophers, false);
-    int finished_count = 0;
+    // phil_id 拿到 fork_id 后，只可能还在等另一把叉子；另一把空闲或已在自己手中则不会等待任何人
+    int other = (left_fork_of[phil_id] == fork_id) ? right_fork_of[phil_id] : left_fork_of[phil_id];
+    int holder = forks[other]->holder;
+    if (other == fork_id || holder == -1 || holder == phil_id) return true;
 
-    // 尝试找到一个顺序，使得每个哲学家都能获得所需资源并完成（类似银行家算法的安全性检测循环）
-    while (finished_count < num_philosophers) {
-        bool found = false;
-        for (int i = 0; i < num_philosophers; ++i) {
-            if (!finish[i]) {
-                if (need[i] <= 0) { 
-                    // 此哲学家当前已满足需求，标记为完成
-                    finish[i] = true;
-                    finished_count++;
-                    found = true;
-                } else {
-                    int left = (static_cast<long long>(i) * num_forks) / num_philosophers;
-                    int right = (left + 1) % num_forks;
-                    
-                    // 检查左右叉子是否都能被该哲学家获取（要么已由其持有，要么为可用）
-                    bool left_ok = (forks[left]->holder == i) || (available[left] == 1);
-                    if (i == phil_id && left == fork_id) left_ok = true; // 模拟我们刚刚给了 phil_id 该叉子
-
-                    bool right_ok = (forks[right]->holder == i) || (available[right] == 1);
-                    if (i == phil_id && right == fork_id) right_ok = true;
-                    
-                    if (left_ok && right_ok) {
-                        // 若该哲学家能够获得足够资源，则认为他可以完成，释放其占用的资源（模拟释放）
-                        finish[i] = true;
-                        finished_count++;
-                        found = true;
-                        if (forks[left]->holder == i) available[left] = 1;
-                        if (forks[right]->holder == i) available[right] = 1;
-                        if (i == phil_id && left == fork_id) available[left] = 1;
-                        if (i == phil_id && right == fork_id) available[right] = 1;
-                    }
-                }
+    if (visit_epoch >= UINT32_MAX - 2) {
+        std::fill(visit_mark.begin(), visit_mark.end(), 0);
+        visit_epoch = 0;
+    }
+    visit_epoch += 2;
+    const uint32_t seen = visit_epoch;
+
+    search_stack.clear();
+    search_stack.push_back(holder);
+    visit_mark[holder] = seen;
+    while (!search_stack.empty()) {
+        int x = search_stack.back();
+        search_stack.pop_back();
+        // 到达一个需要 fork_id 的哲学家：分配后它将等待 phil_id，形成环，系统不安全
+        if (x != phil_id && (left_fork_of[x] == fork_id || right_fork_of[x] == fork_id)) {
+            search_stack.clear();
+            return false;
+        }
+        // 已持有两把叉子的哲学家可以直接完成，没有出边
+        if (banker_need[x] == 0) continue;
+        for (int f : {left_fork_of[x], right_fork_of[x]}) {
+            int h = forks[f]->holder;
+            if (h != -1 && h != x && visit_mark[h] != seen) {
+                visit_mark[h] = seen;
+                search_stack.push_back(h);
             }
         }
-        // 如果遍历一轮没有找到可完成的哲学家，则系统不安全（存在潜在死锁风险）
-        if (!found) return false; 
     }
     return true;
 }
 
+Simulation::AcquireResult Simulation::try_acquire_fork(int phil_id, int fork_id, bool lock_mutex) {
+    // 策略检查与占用登记在同一临界区内完成，避免“检查通过后、登记之前”其他哲学家基于过期状态获得许可
+    lock_traced(state_mutex, phil_id, TraceName::WAIT_STATE_MUTEX);
+    WinLockGuard lock(state_mutex, std::adopt_lock);
+    // 叉子被其他哲学家占用与 try_lock 失败同属 BUSY：持有者释放时一定会唤醒等待者
+    int holder = forks[fork_id]->holder;
+    if (holder != -1 && holder != phil_id) return AcquireResult::BUSY;
+    if (!request_permission(phil_id, fork_id)) return AcquireResult::DENIED;
+    // 使用 WinMutex 的 try_lock 做非阻塞尝试拿锁（虚拟时间模式下单线程运行，不需要真正加锁）
+    if (lock_mutex && !forks[fork_id]->mtx.try_lock()) return AcquireResult::BUSY;
+    register_holder(phil_id, fork_id);
+    return AcquireResult::ACQUIRED;
+}
+
+void Simulation::acquire_fork_blocking(int phil_id, int fork_id) {
+    // 等待发生在叉子自身的互斥量上，不持有任何全局锁；state_mutex 只在拿到叉子后用于 O(1) 的占用登记
+    // （银行家计数、安全性位图与等待图是全体共享的，切换到 BANKER 或开启检测时必须与实际持有情况一致）
+    lock_traced(forks[fork_id]->mtx, phil_id, TraceName::WAIT_FORK);
+    lock_traced(state_mutex, phil_id, TraceName::WAIT_STATE_MUTEX);
+    WinLockGuard lock(state_mutex, std::adopt_lock);
+    register_holder(phil_id, fork_id);
+}
+
+void Simulation::register_holder(int phil_id, int fork_id) {
+    forks[fork_id]->holder = phil_id;
+    snapshot.publish(forks[fork_id]->published_holder, phil_id);
+    banker_need[phil_id]--;
+    safety_bits->set_holder(fork_id, phil_id);
+    update_wait_edges_of_fork(fork_id);
+    if (latency_tracking.load(std::memory_order_acquire)) forks[fork_id]->acquired_ns = clock_ns();
+    if (trace) trace->instant(phil_id, TraceName::ACQUIRE_FORK, clock_ns(), fork_id);
+    // 未经安全性检查的分配可能引入等待环，下一次银行家检查需先做完整检测
+    if (current_strategy != Strategy::BANKER) banker_state_safe = false;
+}
+
+void Simulation::release_fork(int phil_id, int fork_id, bool unlock_mutex) {
+    // 释放只会删除等待边，不会破坏安全状态
+    lock_traced(state_mutex, phil_id, TraceName::WAIT_STATE_MUTEX);
+    WinLockGuard lock(state_mutex, std::adopt_lock);
+    Fork& fork = *forks[fork_id];
+    if (latency_tracking.load(std::memory_order_acquire) && fork.acquired_ns != SIM_NO_TIMESTAMP) {
+        uint64_t now = clock_ns();
+        if (now >= fork.acquired_ns) latency[phil_id].hold.record((now - fork.acquired_ns) / 1000);
+    }
+    if (trace) trace->instant(phil_id, TraceName::RELEASE_FORK, clock_ns(), fork_id);
+    fork.acquired_ns = SIM_NO_TIMESTAMP;
+    fork.holder = -1;
+    snapshot.publish(fork.published_holder, -1);
+    banker_need[phil_id]++;
+    safety_bits->set_holder(fork_id, -1);
+    update_wait_edges_of_fork(fork_id);
+    if (unlock_mutex) {
+        fork.mtx.unlock();
+        // 只唤醒需要这把叉子且正在饥饿的其他哲学家（虚拟时间模式下没有线程在等待）
+        for (int x : fork_users[fork_id]) {
+            if (x != phil_id && phils[x].state.load(std::memory_order_acquire) == State::HUNGRY) {
+                wakeups[x]->post();
+            }
+        }
+    }
+}
+
+void Simulation::set_state(int phil_id, State state) {
+    // 只写该哲学家自己的缓存行；release 保证读到新状态的线程也能看到此前对计数器的更新
+    PhilosopherRecord& p = phils[phil_id];
+    if (state == State::HUNGRY) p.hungry_since_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    if (latency_tracking.load(std::memory_order_acquire) || trace) record_state_change(phil_id, state);
+    bool was_hungry = p.state.load(std::memory_order_relaxed) == State::HUNGRY;
+    p.state.store(state, std::memory_order_release);
+    snapshot.publish(p.published_state, static_cast<int>(state));
+    // 等待边只对 HUNGRY 的哲学家生效：进入或离开 HUNGRY 都会改变检测线程看到的图
+    if (was_hungry || state == State::HUNGRY) wait_graph_version.fetch_add(1, std::memory_order_release);
+}
+
+void Simulation::record_meal(int phil_id) {
+    // 计数器只由哲学家自己写入，其他线程只读，因此用普通的读-改-写即可
+    PhilosopherRecord& p = phils[phil_id];
+    p.eat_count.store(p.eat_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    int waited = p.wait_count.load(std::memory_order_relaxed);
+    if (waited > p.max_wait_count.load(std::memory_order_relaxed)) {
+        p.max_wait_count.store(waited, std::memory_order_relaxed);
+    }
+    p.wait_count.store(0, std::memory_order_relaxed); // 成功进食，重置计数
+}
+
+void Simulation::reset_philosophers() {
+    for (int i = 0; i < num_philosophers; ++i) {
+        phils[i].state.store(State::THINKING);
+        phils[i].wait_count.store(0);
+        phils[i].eat_count.store(0);
+        phils[i].max_wait_count.store(0);
+        phils[i].hungry_since_ns.store(0);
+        snapshot.publish(phils[i].published_state, static_cast<int>(State::THINKING));
+    }
+    for (auto& f : forks) snapshot.publish(f->published_holder, -1);
+    wait_graph_version.fetch_add(1, std::memory_order_release);
+}
+
+void Simulation::update_wait_edge(int phil_id) {
+    // 已拿到一把叉子时等待另一把的持有者；两把都没拿到时等待按当前策略先获取的那一把
+    // （ORDERED 为编号较小的一把，其余策略为左叉子）。是否 HUNGRY 在检测时再筛选
+    int target = -1;
+    int fork_id = -1;
+    int left = left_fork_of[phil_id];
+    int right = right_fork_of[phil_id];
+    bool has_left = forks[left]->holder == phil_id;
+    bool has_right = forks[right]->holder == phil_id;
+    int wanted = -1;
+    if (!has_left && !has_right) {
+        wanted = (current_strategy == Strategy::ORDERED) ? std::min(left, right) : left;
+    } else if (!has_left) {
+        wanted = left;
+    } else if (!has_right) {
+        wanted = right;
+    }
+    if (wanted != -1 && forks[wanted]->holder != -1) {
+        target = forks[wanted]->holder;
+        fork_id = wanted;
+    }
+    if (target == wait_for[phil_id] && fork_id == wait_fork[phil_id]) return;
+    wait_for[phil_id] = target;
+    wait_fork[phil_id] = fork_id;
+    wait_since_ns[phil_id] = (target != -1) ? monotonic_ns() : 0;
+    wait_graph_version.fetch_add(1, std::memory_order_release);
+}
+
+void Simulation::collect_wait_edges(std::vector<int>& edges) {
+    edges.resize(num_philosophers);
+    for (int i = 0; i < num_philosophers; ++i) {
+        edges[i] = (phils[i].state.load(std::memory_order_acquire) == State::HUNGRY) ? wait_for[i] : -1;
+    }
+}
+
+void Simulation::update_wait_edges_of_fork(int fork_id) {
+    // 叉子持有者变化只影响需要这把叉子的哲学家的出边
+    for (int x : fork_users[fork_id]) update_wait_edge(x);
+}
+
+void Simulation::update_all_wait_edges() {
+    for (int i = 0; i < num_philosophers; ++i) update_wait_edge(i);
+}
+
 bool Simulation::request_permission(int phil_id, int fork_id) {
-    // 该函数在修改共享状态前加锁以保证原子性，避免竞态条件
-    WinLockGuard lock(state_mutex);
+    // 调用方（try_acquire_fork）持有 state_mutex：许可检查与随后的占用登记在同一临界区内完成
 
     // 1. 基础检查：叉子是否被占用
     if (forks[fork_id]->holder != -1) return false;
 
     // 2. 反饥饿机制 (Anti-Starvation)
     // 检查所有竞争者是否处于饥饿状态且等待时间超过阈值，如果是则优先礼让，以避免长期饥饿（starvation）。
+    // 竞争者的状态与计数器直接从其原子记录读取（可能略有滞后，只影响礼让时机）
+    int my_wait = phils[phil_id].wait_count.load(std::memory_order_relaxed);
     for (int comp_id : competitors[phil_id]) {
-        if (states[comp_id] == State::HUNGRY && 
-            wait_counts[comp_id] > STARVATION_THRESHOLD && 
-            wait_counts[comp_id] > wait_counts[phil_id]) {
-            return false; // 礼让竞争者
+        const PhilosopherRecord& comp = phils[comp_id];
+        if (comp.state.load(std::memory_order_acquire) == State::HUNGRY) {
+            int comp_wait = comp.wait_count.load(std::memory_order_relaxed);
+            if (comp_wait > STARVATION_THRESHOLD && comp_wait > my_wait) {
+                return false; // 礼让竞争者
+            }
         }
     }
 
-    // 3. 策略分发：若启用了银行家算法策略，则进行安全性检查；否则直接允许分配（乐观分配）
-    if (current_strategy == Strategy::BANKER) {
-        return is_safe_state(phil_id, fork_id);
-    }
-    else {
-        return true; 
-    }
+    // 3. 策略层检查：BANKER 要求分配后状态仍然安全，其余策略直接允许分配（乐观分配）
+    return active_strategy().permits(phil_id, fork_id);
+}
+
+DiningStrategy& Simulation::active_strategy() {
+    return *strategies[static_cast<int>(current_strategy.load())];
 }
 
 void Simulation::philosopher_thread(int id) {
@@ -215,143 +690,148 @@ void Simulation::philosopher_thread(int id) {
     std::uniform_int_distribution<> dis(500, 1000);
 
     while (running) {
-        // THINKING：占用状态锁来安全更新状态数组
-        {
-            WinLockGuard lock(state_mutex);
-            states[id] = State::THINKING;
-        }
-        log_event(id, "STATE", "THINKING");
-        Sleep(dis(gen)); // 使用 Windows API Sleep 替代 std::this_thread::sleep_for
+        // THINKING：只写本哲学家自己的原子记录，不需要全局状态锁；
+        // 思考时长由策略的 pause 度过（默认即 Sleep，消息传递类策略在其中处理来信）
+        set_state(id, State::THINKING);
+        log_event(id, EventKind::STATE, EventReason::THINKING);
+        active_strategy().pause(id, dis(gen));
 
-        // HUNGRY：想要吃饭，开始尝试获取资源，并重置本轮等待计数
-        {
-            WinLockGuard lock(state_mutex);
-            states[id] = State::HUNGRY;
-            wait_counts[id] = 0; // 开始新一轮饥饿，计数归零
-        }
-        log_event(id, "STATE", "HUNGRY");
-
-        bool has_eaten = false;
-        while (running && !has_eaten) {
-            // 先向系统请求是否允许获取左叉子（高层策略判断）
-            if (request_permission(id, left)) {
-                // 使用 WinMutex 的 try_lock 做非阻塞尝试拿锁
-                if (forks[left]->mtx.try_lock()) {
-                    // 成功获得左叉子互斥量后，设置 holder 标志以供其他逻辑读取
-                    forks[left]->holder = id;
-                    log_event(id, "ACQUIRE", "Left Fork " + std::to_string(left));
-
-                    // 小暂停模拟获取第二把叉子的延时（也能暴露出并发竞争）
-                    Sleep(10); // 使用 Windows API Sleep
-
-                    // 请求是否允许获取右叉子
-                    if (request_permission(id, right)) { 
-                        if (forks[right]->mtx.try_lock()) {
-                            // 成功获取右叉子
-                            forks[right]->holder = id;
-                            log_event(id, "ACQUIRE", "Right Fork " + std::to_string(right));
-
-                            // EATING：更新状态并统计，此处对共享状态上锁
-                            {
-                                WinLockGuard lock(state_mutex);
-                                states[id] = State::EATING;
-                                
-                                eat_counts[id]++;
-                                if (wait_counts[id] > max_wait_counts[id]) {
-                                    max_wait_counts[id] = wait_counts[id];
-                                }
-                                wait_counts[id] = 0; // 成功进食，重置计数
-                            }
-                            log_event(id, "STATE", "EATING");
-                            Sleep(dis(gen)); // 使用 Windows API Sleep
-
-                            // 释放资源：先释放右手再释放左手。
-                            forks[right]->holder = -1;
-                            forks[right]->mtx.unlock();
-                            log_event(id, "RELEASE", "Right Fork " + std::to_string(right));
-                            
-                            forks[left]->holder = -1;
-                            forks[left]->mtx.unlock();
-                            log_event(id, "RELEASE", "Left Fork " + std::to_string(left));
-                            
-                            has_eaten = true;
-                        } else {
-                            // 未能拿到右叉子：回退（把左叉子放下），并进行短暂退避以减少活锁竞争
-                            forks[left]->holder = -1;
-                            forks[left]->mtx.unlock();
-                            log_event(id, "RELEASE", "Left Fork " + std::to_string(left) + " (Backoff)");
-                            Sleep(dis(gen) / 10); // 使用 Windows API Sleep
-                        }
-                    } else {
-                         // 策略层拒绝分配右叉子，回退左叉子
-                         forks[left]->holder = -1;
-                         forks[left]->mtx.unlock();
-                         log_event(id, "RELEASE", "Left Fork " + std::to_string(left) + " (Permission Denied)");
-                         Sleep(dis(gen) / 10); // 使用 Windows API Sleep
-                    }
-                }
-            }
-            
-            if (!has_eaten) {
-                // 增加等待计数：用于反饥饿策略判断（注意使用锁同步）
-                {
-                    WinLockGuard lock(state_mutex);
-                    wait_counts[id]++;
-                }
-                // 等待一小段时间后重试，避免 busy-wait
-                Sleep(50); // 使用 Windows API Sleep
-            }
-        }
+        // HUNGRY：想要吃饭，开始尝试获取资源，并重置本轮等待计数（先归零再发布状态，竞争者不会读到上一轮的计数）
+        phils[id].wait_count.store(0, std::memory_order_relaxed);
+        set_state(id, State::HUNGRY);
+        log_event(id, EventKind::STATE, EventReason::HUNGRY);
+
+        // 按当前策略拿齐两把叉子（本轮内不随 set_strategy 切换，保证用同一策略归还）；
+        // 未能拿齐（仿真停止或策略被切换）时回到循环开头
+        DiningStrategy& strategy = active_strategy();
+        if (!strategy.acquire_forks(id, left, right, gen)) continue;
+
+        // EATING：更新状态并统计（均为本哲学家独占的原子记录）
+        record_meal(id);
+        set_state(id, State::EATING);
+        log_event(id, EventKind::STATE, EventReason::EATING);
+        strategy.pause(id, dis(gen));
+
+        strategy.release_forks(id, left, right);
     }
 }
 
 bool Simulation::detect_deadlock() {
-    // 基于当前状态构建等待图（部分资源分配图）并检测环路，如果存在环路则判定为死锁
+    // 等待图随状态切换与叉子获取/释放增量维护，这里只需在 state_mutex 内做一次 O(N) 的染色遍历，
+    // 若存在环路则判定为死锁
     WinLockGuard lock(state_mutex);
-    std::map<int, int> waiting_for; 
-    for (int i = 0; i < num_philosophers; ++i) {
-        if (states[i] == State::HUNGRY) {
-            int left = (static_cast<long long>(i) * num_forks) / num_philosophers;
-            int right = (left + 1) % num_forks;
-            // 如果哲学家 i 等待某把叉子（且该叉子由另一哲学家持有），就在等待图中记录边 i -> holder
-            if (forks[left]->holder != i && forks[left]->holder != -1) {
-                waiting_for[i] = forks[left]->holder;
-            }
-            else if (forks[left]->holder == i && forks[right]->holder != -1 && forks[right]->holder != i) {
-                waiting_for[i] = forks[right]->holder;
-            }
+    collect_wait_edges(detect_edges);
+    int found = -1;
+    for_each_wait_cycle(detect_edges, detect_colour, [&](int entry) {
+        if (found == -1) found = entry;
+    });
+    if (found == -1) return false;
+    log_event(-1, EventKind::DEADLOCK, EventReason::CYCLE, -1, found);
+    return true;
+}
+
+void Simulation::start_deadlock_detector(int interval_ms) {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (interval_ms < 1) throw std::runtime_error("deadlock detector interval must be at least 1 ms");
+    if (detector_running) return;
+    detector_interval_ms = interval_ms;
+    detector_running = true;
+    detector_thread = std::make_unique<WinThread>();
+    detector_thread->start([this]() { this->deadlock_detector_thread(); });
+}
+
+void Simulation::stop_deadlock_detector() {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (!detector_running) return;
+    detector_running = false;
+    detector_wakeup.post();
+    if (detector_thread->joinable()) detector_thread->join();
+    detector_thread.reset();
+    // 吸收线程退出前未消费的唤醒，避免下次启动时立即返回
+    detector_wakeup.try_wait(0);
+}
+
+bool Simulation::deadlock_detector_running() const {
+    return detector_running;
+}
+
+void Simulation::deadlock_detector_thread() {
+    // 后台检测线程：只在持锁期间复制等待图（O(N) 的连续拷贝），染色遍历在锁外进行，不阻塞哲学家线程。
+    // 等待图版本未变的周期直接跳过；已报告过的环（环上每条边的出现时刻都未变）不重复发布
+    std::vector<int> snapshot_wait;
+    std::vector<int> snapshot_fork;
+    std::vector<uint64_t> snapshot_since;
+    std::vector<uint64_t> reported_since(num_philosophers, 0);
+    std::vector<int> colour(num_philosophers, 0);
+    bool scanned = false;
+    uint64_t scanned_version = 0;
+
+    while (detector_running) {
+        detector_wakeup.try_wait(static_cast<DWORD>(detector_interval_ms));
+        if (!detector_running) break;
+        // 先读版本再复制：复制期间发生的变化会使下一周期的版本不同，最多多扫描一次，不会漏掉
+        uint64_t version = wait_graph_version.load(std::memory_order_acquire);
+        if (scanned && version == scanned_version) continue;
+        scanned = true;
+        scanned_version = version;
+        {
+            WinLockGuard lock(state_mutex);
+            collect_wait_edges(snapshot_wait);
+            snapshot_fork = wait_fork;
+            snapshot_since = wait_since_ns;
         }
-    }
-    // 遍历等待图检测环路（使用简单的访问记录），若发现环路说明存在死锁
-    for (auto const& [start_node, _] : waiting_for) {
-        int curr = start_node;
-        std::vector<int> visited;
-        while (waiting_for.count(curr)) {
-            visited.push_back(curr);
-            curr = waiting_for[curr];
-            if (std::find(visited.begin(), visited.end(), curr) != visited.end()) {
-                log_event(-1, "DEADLOCK", "Cycle detected involving Phil " + std::to_string(curr));
-                return true;
-            }
+        // 等待边在哲学家进入 HUNGRY 后才生效，出现时刻取两者中较晚的一个
+        for (int i = 0; i < num_philosophers; ++i) {
+            if (snapshot_wait[i] == -1) continue;
+            snapshot_since[i] = std::max(snapshot_since[i],
+                                         phils[i].hungry_since_ns.load(std::memory_order_relaxed));
         }
+
+        uint64_t now = monotonic_ns();
+        for_each_wait_cycle(snapshot_wait, colour, [&](int entry) {
+            // 成环时刻为环上最晚出现的那条等待边
+            uint64_t formed_ns = 0;
+            int length = 0;
+            bool reported = true;
+            int x = entry;
+            do {
+                formed_ns = std::max(formed_ns, snapshot_since[x]);
+                reported = reported && reported_since[x] == snapshot_since[x];
+                length++;
+                x = snapshot_wait[x];
+            } while (x != entry);
+            if (reported) return;
+
+            x = entry;
+            do {
+                reported_since[x] = snapshot_since[x];
+                log_event(x, EventKind::DEADLOCK, EventReason::CYCLE_MEMBER, snapshot_fork[x], length);
+                x = snapshot_wait[x];
+            } while (x != entry);
+            uint64_t latency_us = (now > formed_ns) ? (now - formed_ns) / 1000 : 0;
+            if (latency_us > INT32_MAX) latency_us = INT32_MAX;
+            log_event(entry, EventKind::DEADLOCK, EventReason::DETECTION_LATENCY, -1,
+                      static_cast<int>(latency_us));
+        });
     }
-    return false;
 }
 
 std::vector<std::vector<int>> Simulation::get_resource_graph() {
     // 返回资源图的一个表示：每个 edge 三元组含义为 {philosopher, resource, holding_flag}
-    // holding_flag = 1 表示哲学家占有该资源，0 表示在请求但未占有
-    WinLockGuard lock(state_mutex);
+    // holding_flag = 1 表示哲学家占有该资源，0 表示在请求但未占有。
+    // 状态与持有者取自同一版本的快照，不获取 state_mutex，也就不会阻塞哲学家线程
+    SimSnapshot snap = get_snapshot();
     std::vector<std::vector<int>> edges;
     for (int i = 0; i < num_philosophers; ++i) {
-        int left = (static_cast<long long>(i) * num_forks) / num_philosophers;
-        int right = (left + 1) % num_forks;
-        if (states[i] == State::EATING) {
+        int left = left_fork_of[i];
+        int right = right_fork_of[i];
+        State state = static_cast<State>(snap.states[i]);
+        if (state == State::EATING) {
             edges.push_back({ i, left, 1 });  
             edges.push_back({ i, right, 1 });
         }
-        else if (states[i] == State::HUNGRY) {
-            if (forks[left]->holder == i) {
+        else if (state == State::HUNGRY) {
+            if (snap.fork_holders[left] == i) {
                 edges.push_back({ i, left, 1 });   
                 edges.push_back({ i, right, 0 });  
             }
@@ -364,9 +844,258 @@ std::vector<std::vector<int>> Simulation::get_resource_graph() {
 }
 
 std::vector<int> Simulation::get_states() {
-    // 获取所有哲学家的状态（用于 UI 或外部监控），对共享状态上锁以保证一致性
-    WinLockGuard lock(state_mutex);
+    // 获取所有哲学家的状态（用于 UI 或外部监控）：读取发布的快照，多个监控高频轮询也不影响仿真
     std::vector<int> result;
-    for (auto s : states) result.push_back(static_cast<int>(s));
+    std::vector<int> holders;
+    read_snapshot(result, holders);
     return result;
-}
\ No newline at end of file
+}
+
+SimSnapshot Simulation::get_snapshot() const {
+    SimSnapshot snap;
+    snap.version = read_snapshot(snap.states, snap.fork_holders);
+    return snap;
+}
+
+uint64_t Simulation::read_snapshot(std::vector<int>& states, std::vector<int>& holders) const {
+    return snapshot.read(num_philosophers, [this](int i) -> const SnapshotSlot& { return phils[i].published_state; },
+                         num_forks, [this](int f) -> const SnapshotSlot& { return forks[f]->published_holder; },
+                         states, holders);
+}
+
+long long Simulation::begin_thinking(int id, uint64_t ts_ns, std::mt19937& gen) {
+    std::uniform_int_distribution<> dis(500, 1000);
+    set_state(id, State::THINKING);
+    log_event_at(ts_ns, id, EventKind::STATE, EventReason::THINKING);
+    return dis(gen);
+}
+
+void Simulation::become_hungry(int id, uint64_t ts_ns) {
+    phils[id].wait_count.store(0, std::memory_order_relaxed);
+    set_state(id, State::HUNGRY);
+    log_event_at(ts_ns, id, EventKind::STATE, EventReason::HUNGRY);
+}
+
+bool Simulation::take_left_fork(int id, uint64_t ts_ns, int& attempt, std::mt19937& gen, long long& delay_ms) {
+    int left = left_fork_of[id];
+    AcquireResult result = try_acquire_fork(id, left, false);
+    if (result == AcquireResult::ACQUIRED) {
+        backoff.record(left, true);
+        log_event_at(ts_ns, id, EventKind::ACQUIRE, EventReason::LEFT_FORK, left);
+        return true;
+    }
+    if (result == AcquireResult::BUSY) backoff.record(left, false);
+    delay_ms = back_off_delay(id, result == AcquireResult::BUSY ? BackoffSite::LEFT_FORK_BUSY : BackoffSite::LEFT_FORK_DENIED,
+                              left, attempt, gen);
+    return false;
+}
+
+bool Simulation::take_right_fork(int id, uint64_t ts_ns, int& attempt, std::mt19937& gen, long long& delay_ms) {
+    std::uniform_int_distribution<> dis(500, 1000);
+    int left = left_fork_of[id];
+    int right = right_fork_of[id];
+    AcquireResult result = try_acquire_fork(id, right, false);
+    if (result == AcquireResult::ACQUIRED) {
+        backoff.record(right, true);
+        log_event_at(ts_ns, id, EventKind::ACQUIRE, EventReason::RIGHT_FORK, right);
+        record_meal(id);
+        set_state(id, State::EATING);
+        log_event_at(ts_ns, id, EventKind::STATE, EventReason::EATING);
+        delay_ms = dis(gen);
+        return true;
+    }
+    // 右叉子被占用或被策略层拒绝，回退左叉子并退避，退避结束后直接重试左叉子
+    if (result == AcquireResult::BUSY) backoff.record(right, false);
+    release_fork(id, left, false);
+    log_event_at(ts_ns, id, EventKind::RELEASE,
+                 result == AcquireResult::BUSY ? EventReason::LEFT_FORK_BACKOFF : EventReason::LEFT_FORK_DENIED, left);
+    delay_ms = back_off_delay(id, BackoffSite::RIGHT_FORK_FAILED, right, attempt, gen);
+    return false;
+}
+
+BackoffStep Simulation::back_off(int id, BackoffSite site, int fork_id, int& attempt, std::mt19937& gen) {
+    // 增加等待计数：用于反饥饿策略判断（原子写入，竞争者可随时读取）。只计入休眠（阻塞等待）的轮次：
+    // 自旋与让出时间片的轮次几乎不占时间，计入的话自旋者很快越过 STARVATION_THRESHOLD，礼让反而偏向了它
+    BackoffStep step = backoff.next(site, attempt++, fork_id, gen);
+    if (step.action == BackoffStep::Action::SLEEP) phils[id].wait_count.fetch_add(1, std::memory_order_relaxed);
+    return step;
+}
+
+long long Simulation::back_off_delay(int id, BackoffSite site, int fork_id, int& attempt, std::mt19937& gen) {
+    BackoffStep step = back_off(id, site, fork_id, attempt, gen);
+    return step.action == BackoffStep::Action::SLEEP ? static_cast<long long>(step.ms) : 0;
+}
+
+void Simulation::finish_eating(int id, uint64_t ts_ns) {
+    int left = left_fork_of[id];
+    int right = right_fork_of[id];
+    release_fork(id, right, false);
+    log_event_at(ts_ns, id, EventKind::RELEASE, EventReason::RIGHT_FORK, right);
+    release_fork(id, left, false);
+    log_event_at(ts_ns, id, EventKind::RELEASE, EventReason::LEFT_FORK, left);
+}
+
+long long Simulation::step_philosopher(int id, TaskAction& action, uint64_t ts_ns, std::mt19937& gen) {
+    long long delay_ms = 0;
+    switch (action) {
+    case TaskAction::FINISH_EATING:
+        finish_eating(id, ts_ns);
+        // 进餐结束后回到 THINKING
+        // fall through
+    case TaskAction::THINK:
+        action = TaskAction::BECOME_HUNGRY;
+        return begin_thinking(id, ts_ns, gen);
+
+    case TaskAction::BECOME_HUNGRY:
+        become_hungry(id, ts_ns);
+        task_attempts[id] = 0;
+        action = TaskAction::TRY_LEFT;
+        return 0;
+
+    case TaskAction::TRY_LEFT:
+        if (take_left_fork(id, ts_ns, task_attempts[id], gen, delay_ms)) {
+            action = TaskAction::TRY_RIGHT;
+            return SECOND_FORK_DELAY_MS;
+        }
+        return delay_ms;
+
+    case TaskAction::TRY_RIGHT:
+        action = take_right_fork(id, ts_ns, task_attempts[id], gen, delay_ms) ? TaskAction::FINISH_EATING
+                                                                                : TaskAction::TRY_LEFT;
+        return delay_ms;
+    }
+    return 0;
+}
+
+namespace {
+
+struct VirtualEvent {
+    long long time_us;   // 虚拟时间（微秒）
+    long long seq;       // 同一时刻按插入顺序处理，保证结果可复现
+    int phil_id;
+    TaskAction action;
+
+    bool operator>(const VirtualEvent& other) const {
+        if (time_us != other.time_us) return time_us > other.time_us;
+        return seq > other.seq;
+    }
+};
+
+} // namespace
+
+SimStats Simulation::run_virtual(double duration_sec, unsigned int seed) {
+    // 离散事件仿真：用按时间戳排序的优先队列代替每个线程中的 Sleep，
+    // 虚拟时钟直接跳到下一个事件的时间点，因此数小时的“桌面时间”可在数秒内跑完。
+    // 全部事件在调用线程中顺序处理，状态机（step_philosopher）与 philosopher_thread 一一对应。
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (running) {
+        throw std::runtime_error("run_virtual cannot be used while the threaded simulation is running");
+    }
+    if (active_strategy().threaded_only()) {
+        throw std::runtime_error("the current strategy blocks on fork mutexes and is only available in threaded mode");
+    }
+
+    {
+        WinLockGuard lock(state_mutex);
+        reset_philosophers();
+        for (int i = 0; i < num_philosophers; ++i) {
+            banker_need[i] = 2;
+            wait_for[i] = -1;
+            wait_fork[i] = -1;
+            wait_since_ns[i] = 0;
+        }
+        for (auto& f : forks) f->holder = -1;
+        safety_bits->reset();
+        banker_state_safe = true;
+    }
+
+    std::mt19937 gen(seed);
+    const long long MS = 1000;
+    const long long end_us = static_cast<long long>(duration_sec * 1e6);
+
+    std::priority_queue<VirtualEvent, std::vector<VirtualEvent>, std::greater<VirtualEvent>> agenda;
+    long long seq = 0;
+    long long now_us = 0;
+    auto vts = [&]() { return static_cast<uint64_t>(now_us) * 1000; };
+    // 执行一步（单线程下叉子只登记占用，与线程模式共用策略检查与银行家状态），并把下一个动作按其等待时长放入日程
+    auto run_step = [&](int id, TaskAction action) {
+        virtual_now_ns = vts();
+        long long delay_ms = step_philosopher(id, action, vts(), gen);
+        agenda.push({now_us + delay_ms * MS, seq++, id, action});
+    };
+
+    // 延迟直方图与进餐计数一样只统计本次运行，并按虚拟时间计时
+    if (latency_tracking.load()) {
+        for (int i = 0; i < num_philosophers; ++i) latency[i].reset();
+    }
+    reset_state_timestamps();
+    task_attempts.assign(num_philosophers, 0);
+    virtual_clock = true;
+    begin_trace(vts());
+    log_event_at(vts(), -1, EventKind::SYSTEM, EventReason::VIRTUAL_STARTED);
+    for (int i = 0; i < num_philosophers; ++i) run_step(i, TaskAction::THINK);
+
+    SimStats stats{};
+    while (!agenda.empty() && agenda.top().time_us <= end_us) {
+        VirtualEvent ev = agenda.top();
+        agenda.pop();
+        now_us = ev.time_us;
+        stats.events_processed++;
+
+        run_step(ev.phil_id, ev.action);
+    }
+    now_us = end_us;
+
+    // 收集统计信息（与 stop() 一致地以 STATS 事件记录）
+    stats.elapsed = duration_sec;
+    for (int i = 0; i < num_philosophers; ++i) {
+        PhilosopherRecord& p = phils[i];
+        if (p.state.load() == State::HUNGRY && p.wait_count.load() > p.max_wait_count.load()) {
+            p.max_wait_count.store(p.wait_count.load());
+        }
+        stats.eat_counts.push_back(p.eat_count.load());
+        stats.max_wait_counts.push_back(p.max_wait_count.load());
+        stats.total_meals += p.eat_count.load();
+        log_event_at(vts(), i, EventKind::STATS, EventReason::EAT_COUNT, -1, p.eat_count.load());
+        log_event_at(vts(), i, EventKind::STATS, EventReason::MAX_WAIT, -1, p.max_wait_count.load());
+    }
+    finish_trace(vts());
+    log_event_at(vts(), -1, EventKind::SYSTEM, EventReason::VIRTUAL_STOPPED);
+    virtual_clock = false;
+    return stats;
+}
+
+void Simulation::start_tasks(int num_workers) {
+    WinLockGuard lifecycle(lifecycle_mutex);
+    if (running) return;
+    enter_task_mode();
+    task_actions.assign(num_philosophers, TaskAction::THINK);
+    task_attempts.assign(num_philosophers, 0);
+    launch_tasks(num_workers, [this](int id, std::mt19937& gen) {
+        return step_philosopher(id, task_actions[id], monotonic_ns(), gen);
+    });
+}
+
+void Simulation::enter_task_mode() {
+    // 与 set_strategy 在同一把锁下检查，保证任务模式运行期间不会切换到阻塞式策略
+    WinLockGuard lock(state_mutex);
+    if (active_strategy().threaded_only()) {
+        throw std::runtime_error("the current strategy blocks on fork mutexes and is not available in task mode");
+    }
+    task_mode = true;
+}
+
+void Simulation::launch_tasks(int num_workers, std::function<long long(int, std::mt19937&)> step) {
+    tasks = std::make_unique<TaskScheduler>(num_philosophers, num_workers, std::move(step));
+    running = true;
+    reset_state_timestamps();
+    begin_trace(clock_ns());
+    tasks->start();
+    log_event(-1, EventKind::SYSTEM, EventReason::SIM_STARTED);
+}
+
+#ifndef SIM_HAVE_COROUTINES
+void Simulation::start_coroutines(int /*num_workers*/) {
+    throw std::runtime_error("sim_core was built without coroutine support (configure with -DSIM_ENABLE_COROUTINES=ON)");
+}
+#endif
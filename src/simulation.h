@@ -2,30 +2,138 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include <deque>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <functional>
+#include <random>
 #include "win_sync.h" // 使用 Windows 同步原语封装
+#include "mpsc_ring.h"
+#include "safety_bitset.h"
+#include "state_snapshot.h"
+#include "backoff.h"
+#include "latency_histogram.h"
+#include "lock_profile.h"
+#include "trace_recorder.h"
 
 enum class State { THINKING, HUNGRY, EATING };
-enum class Strategy { NONE, BANKER }; 
+enum class Strategy { NONE, BANKER, ORDERED, CHANDY_MISRA, WAITER }; 
+enum class OverflowPolicy { OVERWRITE_OLDEST, DROP_NEWEST };
+enum class TimerMode { SLEEP, WHEEL };
+
+// 虚拟时间模式与任务模式共用的哲学家状态机动作，对应 philosopher_thread 中每一次 Sleep 结束后的操作
+enum class TaskAction : uint8_t {
+    THINK,          // 进入 THINKING（仅用于开始运行时）
+    BECOME_HUNGRY,  // 思考结束，进入 HUNGRY
+    TRY_LEFT,       // 尝试获取左叉子（失败时退避后再试）
+    TRY_RIGHT,      // 拿到左叉子 10ms 后尝试获取右叉子（失败时放下左叉子，退避后重试左叉子）
+    FINISH_EATING   // 进餐结束，释放叉子并回到 THINKING
+};
+
+// 缓存行大小：MSVC 等直接使用 std::hardware_destructive_interference_size；
+// GCC 会对在头文件中使用该常量给出 ABI 警告（其值随 -mtune 变化），因此按常见的 64 字节处理
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+constexpr size_t SIM_CACHE_LINE = std::hardware_destructive_interference_size;
+#else
+constexpr size_t SIM_CACHE_LINE = 64;
+#endif
+
+// 延迟直方图使用的“尚无时间戳”标记（虚拟时间模式下 0 是合法的时刻）
+constexpr uint64_t SIM_NO_TIMESTAMP = ~uint64_t(0);
+
+// 每个哲学家独占一条缓存行的状态记录：状态与计数器都是原子量，只由该哲学家自己的线程写入，
+// 其他线程（反饥饿检查、监控读取）只读。相邻哲学家的更新不再伪共享，状态切换也不需要 state_mutex
+struct alignas(SIM_CACHE_LINE) PhilosopherRecord {
+    std::atomic<State> state;
+    std::atomic<int> wait_count;         // 本轮饥饿的等待轮数（反饥饿策略使用）
+    std::atomic<int> eat_count;
+    std::atomic<int> max_wait_count;
+    std::atomic<uint64_t> hungry_since_ns; // 最近一次进入 HUNGRY 的时刻，死锁检测用于计算成环时间
+    std::atomic<uint64_t> state_since_ns;  // 进入当前状态的时刻，只在记录延迟直方图或时间线追踪时维护
+    SnapshotSlot published_state;          // 发布给监控读取的状态（见 state_snapshot.h），与上面的字段同在本缓存行
+
+    PhilosopherRecord()
+        : state(State::THINKING), wait_count(0), eat_count(0), max_wait_count(0), hungry_since_ns(0),
+          state_since_ns(SIM_NO_TIMESTAMP), published_state(static_cast<int>(State::THINKING)) {}
+};
 
 struct Fork {
     WinMutex mtx; // 使用 WinMutex
     int holder; 
+    uint64_t acquired_ns; // 最近一次登记占用的时刻（受 state_mutex 保护），只在记录延迟直方图时维护
+    SnapshotSlot published_holder; // 发布给监控读取的持有者（在 state_mutex 内写入，见 state_snapshot.h）
     
-    Fork() : holder(-1) {}
+    Fork() : holder(-1), acquired_ns(SIM_NO_TIMESTAMP), published_holder(-1) {}
     
     // 禁止拷贝
     Fork(const Fork&) = delete;
     Fork& operator=(const Fork&) = delete;
 };
 
+// 事件种类与原因码：事件以紧凑的 POD 记录保存，人类可读的字符串仅在 Python 边界（main.cpp）按需生成
+enum class EventKind : uint8_t { SYSTEM, STATE, ACQUIRE, RELEASE, STATS, DEADLOCK };
+enum class EventReason : uint8_t {
+    NONE,
+    THINKING, HUNGRY, EATING,                                  // STATE
+    LEFT_FORK, RIGHT_FORK, LEFT_FORK_BACKOFF, LEFT_FORK_DENIED, // ACQUIRE / RELEASE
+    SIM_STARTED, SIM_STOPPED, STRATEGY_CHANGED,                // SYSTEM
+    VIRTUAL_STARTED, VIRTUAL_STOPPED,
+    EAT_COUNT, MAX_WAIT,                                       // STATS
+    CYCLE, CYCLE_MEMBER, DETECTION_LATENCY                     // DEADLOCK
+};
+
+// 定长事件记录（24 字节），直接写入无锁环形队列，热路径上不产生任何堆分配
 struct SimEvent {
-    double timestamp;
-    int phil_id;
-    std::string event_type; 
-    std::string details;
+    uint64_t timestamp_ns;  // 单调时钟纳秒（虚拟模式下为虚拟时间）
+    int32_t phil_id;        // -1 表示系统事件
+    int32_t fork_id;        // ACQUIRE / RELEASE 的叉子编号，其余为 -1
+    int32_t value;          // 附加数值：STATS 的计数、STRATEGY_CHANGED 的策略码、DEADLOCK 的环上哲学家 / 环长 / 检测延迟（微秒）
+    EventKind kind;
+    EventReason reason;
+    uint16_t reserved;
+};
+static_assert(sizeof(SimEvent) == 24, "SimEvent must stay a compact 24-byte record");
+
+// 事件日志计数器：队列满时按溢出策略丢弃新事件或覆盖最旧事件，并在此显式计数
+struct EventLogStats {
+    uint64_t logged;       // 成功写入的事件数
+    uint64_t dropped;      // 因队列满被丢弃的新事件数（DROP_NEWEST）
+    uint64_t overwritten;  // 被新事件覆盖掉的旧事件数（OVERWRITE_OLDEST）
+    uint64_t capacity;     // 环形队列容量
+};
+
+// 一次运行的统计结果（虚拟时间模式下由 run_virtual 返回）
+struct SimStats {
+    double elapsed;                    // 运行时长（秒，虚拟模式下为虚拟时间）
+    long long total_meals;             // 所有哲学家的进餐总次数
+    long long events_processed;        // 处理的离散事件数
+    std::vector<int> eat_counts;       // 每个哲学家的进餐次数
+    std::vector<int> max_wait_counts;  // 每个哲学家的最大等待轮数
+};
+
+// 延迟直方图的度量：WAIT = HUNGRY 到 EATING，HOLD = 叉子从登记占用到释放，THINK / EAT = 思考 / 进餐时长
+enum class LatencyMetric { WAIT, HOLD, THINK, EAT };
+
+// 延迟分布的摘要（毫秒），由 get_latency_percentiles 返回
+struct LatencyPercentiles {
+    uint64_t count;
+    double p50;
+    double p99;
+    double p999;
+    double max;
+};
+
+// 监控读取的一致快照：同一版本下的哲学家状态与叉子持有者（-1 表示空闲）
+struct SimSnapshot {
+    uint64_t version;               // 快照版本，每次状态或持有者变化加一
+    std::vector<int> states;        // 与 get_states() 相同的状态码
+    std::vector<int> fork_holders;
 };
 
+class DiningStrategy;
+class TaskScheduler;
+class TimerService;
+
 class Simulation {
 public:
     Simulation(int n_phil, int n_forks);
@@ -34,40 +142,228 @@ public:
     void start();
     void stop();
     
+    // 0 = NONE（乐观 try-lock），1 = BANKER（银行家算法），2 = ORDERED（按叉子编号阻塞获取），
+    // 3 = CHANDY_MISRA（脏/净叉子消息传递，要求 N <= M），4 = WAITER（信号量限制入座人数），见 strategy.h
     void set_strategy(int strategy_code);
 
+    // try-lock 路径（NONE / BANKER）的退避策略：0 = FIXED（默认），1 = EXPONENTIAL，
+    // 2 = ADAPTIVE，3 = SPIN_YIELD_SLEEP，参数含义见 backoff.h；切换时清零退避计数器与争用估计
+    void set_backoff_policy(int policy_code, int base_ms = 5, int max_ms = 200,
+                            int spin_limit = 100, int yield_limit = 10);
+    BackoffStats get_backoff_stats() const;
+
+    // 线程模式下定时等待（思考、进餐、退避与等待叉子的超时）的实现：0 = SLEEP（默认，每个线程各自 Sleep /
+    // 带超时等待，原有行为），1 = WHEEL（登记到共享的分层时间轮，由一个服务线程按 tick 成批唤醒，见 timer_service.h；
+    // stop() 时所有定时等待立即结束）。下一次 start() 时生效
+    void set_timer_mode(int mode_code);
+
+    // 延迟直方图（可选）：启用后为每位哲学家分别记录 WAIT / HOLD / THINK / EAT 四个无锁 HDR 直方图
+    // （见 latency_histogram.h，每位哲学家约 14KB，首次启用时分配）；启用时清零，run_virtual 开始时也清零，
+    // 虚拟时间模式下按虚拟时间计时。未启用时热路径上只多一次原子读取
+    void set_latency_tracking(bool enabled);
+    // metric 取 LatencyMetric 的编号 0..3；phil_id 为 -1 时合并全部哲学家。参数非法时抛出 std::runtime_error
+    LatencyPercentiles get_latency_percentiles(int metric, int phil_id = -1) const;
+
+    // 锁争用剖析（可选）：启用时清零并为 state_mutex、lifecycle_mutex 与每把叉子的 Fork::mtx 挂接统计对象
+    // （见 lock_profile.h），记录获取次数、争用次数、try_lock 失败次数、等待与持有总时长；未启用时开销可忽略。
+    // get_lock_stats 依次返回 state_mutex、lifecycle_mutex、全部叉子的合计 "forks"，以及有过活动的每把叉子 "fork[i]"
+    void set_lock_profiling(bool enabled);
+    std::vector<LockStats> get_lock_stats() const;
+
+    // 时间线追踪（可选）：path 非空时，此后每次 start / start_tasks / start_coroutines / run_virtual 记录每位哲学家的
+    // THINKING / HUNGRY / EATING 区间、叉子获取与释放的瞬时事件，以及在叉子互斥量与 state_mutex 上的等待区间，
+    // 由 stop()（虚拟时间模式为 run_virtual 结束时）写出为 Chrome Trace Event JSON（见 trace_recorder.h），覆盖同名文件。
+    // 记录写入各线程私有的缓冲区，每个线程至多 max_events_per_thread 条，超出部分丢弃并在文件的 otherData 中计数。
+    // path 为空时关闭追踪；文件无法创建或 max_events_per_thread <= 0 时抛出 std::runtime_error
+    void set_trace_output(const std::string& path, int max_events_per_thread = 1000000);
+
     std::vector<int> get_states();
     std::vector<std::vector<int>> get_resource_graph();
+    // get_states / get_resource_graph / get_snapshot 只读取各槽位发布的快照（见 state_snapshot.h），不获取 state_mutex
+    SimSnapshot get_snapshot() const;
     
     std::vector<SimEvent> poll_events();
+    EventLogStats get_event_log_stats() const;
+    void set_event_overflow_policy(int policy_code);
 
     bool detect_deadlock();
 
+    // 后台死锁检测（可选）：独立线程每隔 interval_ms 检查增量维护的等待图，
+    // 发现新的等待环时发布 DEADLOCK 事件：每个环上成员一条 CYCLE_MEMBER（fork_id 为其等待的叉子，value 为环长），
+    // 随后一条 DETECTION_LATENCY（phil_id 为环的入口，value 为从成环到被发现的微秒数）
+    void start_deadlock_detector(int interval_ms = 10);
+    void stop_deadlock_detector();
+    bool deadlock_detector_running() const;
+
+    // 虚拟时间离散事件模式：单线程按时间戳顺序推进虚拟时钟，
+    // 运行与线程模式相同的状态机、request_permission 与反饥饿规则，但不真正睡眠
+    SimStats run_virtual(double duration_sec, unsigned int seed = 0);
+
+    // M:N 任务模式：哲学家作为状态机任务在工作窃取线程池（num_workers <= 0 时为硬件线程数）上运行，
+    // 思考、进餐与重试的定时等待是时间轮上的条目而不是阻塞的 Sleep，因此可以运行百万量级的哲学家。
+    // 状态机与虚拟时间模式相同（只支持 NONE / BANKER），由 stop() 停止
+    void start_tasks(int num_workers = 0);
+
+    // 协程任务模式：每个哲学家是一个 co_await 驱动的 C++20 协程（等待思考定时器、等待叉子、等待进餐定时器），
+    // 与 start_tasks 共用工作窃取执行器、request_permission 与反饥饿规则。
+    // 需以 SIM_ENABLE_COROUTINES 构建（见 philosopher_coroutine.cpp），否则抛出 std::runtime_error
+    void start_coroutines(int num_workers = 0);
+
 private:
+    friend class DiningStrategy;
+    friend class CoroutinePhilosophers;
+
     int num_philosophers;
     int num_forks;
     volatile bool running; 
-    Strategy current_strategy;
+    std::atomic<Strategy> current_strategy;
+    // 每种 Strategy 对应的策略对象（按枚举值索引），哲学家每轮 HUNGRY 时按 current_strategy 选取
+    std::vector<std::unique_ptr<DiningStrategy>> strategies;
+    DiningStrategy& active_strategy();
 
-    std::vector<State> states;
+    // 每个哲学家的状态与计数器（饥饿计数器用于防止饥饿），按缓存行对齐分配
+    std::unique_ptr<PhilosopherRecord[]> phils;
     std::vector<std::unique_ptr<Fork>> forks;
     std::vector<std::unique_ptr<WinThread>> threads; // 使用 WinThread
+    // 每位哲学家的唤醒信号量（二值）：释放叉子时唤醒该叉子上饥饿的其他使用者，代替固定间隔的轮询重试
+    std::vector<std::unique_ptr<WinSemaphore>> wakeups;
+    // 线程模式的共享定时器服务（WHEEL 模式下由 start() 创建、stop() 销毁）
+    std::atomic<TimerMode> timer_mode;
+    std::unique_ptr<TimerService> timers;
+    // 哲学家线程的定时等待：WHEEL 模式经由 timers，否则 Sleep / sem.try_wait；后者在 sem 被 post 时返回 true
+    void timed_sleep(int phil_id, DWORD ms);
+    bool timed_wait(int phil_id, WinSemaphore& sem, DWORD ms);
+    BackoffPolicy backoff;
+    // 供监控读取的状态与叉子持有者快照，由 set_state 与叉子的获取/释放同步发布到各自记录中的槽位
+    StateSnapshot snapshot;
+    uint64_t read_snapshot(std::vector<int>& states, std::vector<int>& holders) const;
     
-    // 饥饿计数器，用于防止饥饿
-    std::vector<int> wait_counts;
-    std::vector<int> eat_counts;
-    std::vector<int> max_wait_counts;
     std::vector<std::vector<int>> competitors;
     const int STARVATION_THRESHOLD = 10;
 
-    WinMutex event_mutex; // 使用 WinMutex
-    std::deque<SimEvent> event_queue;
-    void log_event(int phil_id, const std::string& type, const std::string& details);
+    // 事件日志：有界无锁 MPSC 环形队列，哲学家线程写入时无需加锁
+    static const size_t EVENT_CAPACITY = 8192;
+    MpscRing<SimEvent> event_ring;
+    std::atomic<OverflowPolicy> overflow_policy;
+    void log_event(int phil_id, EventKind kind, EventReason reason, int fork_id = -1, int value = 0);
+    void log_event_at(uint64_t ts_ns, int phil_id, EventKind kind, EventReason reason,
+                      int fork_id = -1, int value = 0);
 
     WinMutex state_mutex; // 使用 WinMutex
+    // 串行化 start / stop / run_virtual 与检测线程的启停：绑定层调用它们时已释放 GIL，可能被多个 Python 线程并发调用
+    WinMutex lifecycle_mutex;
 
     void philosopher_thread(int id);
-    bool request_permission(int phil_id, int fork_id);
-    
+
+    // 执行哲学家 id 的 action 并把它改为下一个动作，返回到下一个动作之前的等待时长（毫秒）；ts_ns 为事件时间戳。
+    // 叉子只登记占用、不锁 Fork::mtx（任务可能在不同线程上释放它拿到的叉子）
+    long long step_philosopher(int id, TaskAction& action, uint64_t ts_ns, std::mt19937& gen);
+    // step_philosopher 与协程版哲学家共用的状态转换：返回值（或 delay_ms）是转换之后要等待的毫秒数。
+    // attempt 为本轮饥饿中此前退避的次数，由调用方保存，每次退避后加一
+    static const int SECOND_FORK_DELAY_MS = 10;  // 拿到左叉子后再尝试右叉子之前的延时
+    long long begin_thinking(int id, uint64_t ts_ns, std::mt19937& gen);
+    void become_hungry(int id, uint64_t ts_ns);
+    // 拿到左叉子时返回 true；否则 delay_ms 为再次尝试之前的退避时长
+    bool take_left_fork(int id, uint64_t ts_ns, int& attempt, std::mt19937& gen, long long& delay_ms);
+    // 拿到右叉子时开始进餐并返回 true，delay_ms 为进餐时长；否则放下左叉子，delay_ms 为重试左叉子之前的退避时长
+    bool take_right_fork(int id, uint64_t ts_ns, int& attempt, std::mt19937& gen, long long& delay_ms);
+    void finish_eating(int id, uint64_t ts_ns);
+    // 一次获取失败之后的退避，线程模式的 try-lock 策略与上面的状态转换共用，各模式的重试节奏因此一致：
+    // 累计等待次数并按退避策略给出再次尝试左叉子之前的动作，attempt 加一。
+    // 状态转换中自旋与让出时间片不占用时间，按 0ms 处理（back_off_delay）
+    BackoffStep back_off(int id, BackoffSite site, int fork_id, int& attempt, std::mt19937& gen);
+    long long back_off_delay(int id, BackoffSite site, int fork_id, int& attempt, std::mt19937& gen);
+    // 以下两个函数的调用方持有 lifecycle_mutex：前者检查并进入任务模式，后者以 step 创建调度器并启动
+    void enter_task_mode();
+    void launch_tasks(int num_workers, std::function<long long(int, std::mt19937&)> step);
+    std::unique_ptr<TaskScheduler> tasks;
+    std::vector<TaskAction> task_actions;  // 任务模式下每个哲学家的下一个动作，只由当前执行该任务的线程访问
+    std::vector<int> task_attempts;        // 任务模式与虚拟时间模式下每个哲学家本轮饥饿中已退避的次数（同上）
+    bool task_mode;                        // 任务模式运行中（受 state_mutex 保护），此时不能切换到阻塞式策略
+    void set_state(int phil_id, State state);
+    void record_meal(int phil_id);
+
+    // 延迟直方图：首次启用时分配，之后不再释放（哲学家线程看到 latency_tracking 后才访问）
+    struct PhilosopherLatency {
+        LatencyHistogram wait;
+        LatencyHistogram hold;
+        LatencyHistogram think;
+        LatencyHistogram eat;
+
+        void reset() {
+            wait.reset();
+            hold.reset();
+            think.reset();
+            eat.reset();
+        }
+    };
+    std::unique_ptr<PhilosopherLatency[]> latency;
+    std::atomic<bool> latency_tracking;
+    // run_virtual 期间计时使用虚拟时钟（只由 run_virtual 的线程读写）
+    bool virtual_clock;
+    uint64_t virtual_now_ns;
+    uint64_t clock_ns() const;
+    void record_state_change(int phil_id, State next);
+    void reset_state_timestamps();
+
+    // 时间线追踪：配置受 lifecycle_mutex 保护；记录器在各模式开始运行前创建、停止后写出并销毁，
+    // 运行期间只由哲学家线程（任务）读取
+    std::string trace_path;
+    size_t trace_limit;
+    std::unique_ptr<TraceRecorder> trace;
+    void begin_trace(uint64_t origin_ns);  // 以下两个函数的调用方持有 lifecycle_mutex
+    void finish_trace(uint64_t end_ns);
+    // 加锁 m；追踪时若锁被占用，把等待记录为 phil_id 名下的 name 区间
+    void lock_traced(WinMutex& m, int phil_id, TraceName name);
+
+    // 锁剖析的统计对象：[0] state_mutex，[1] lifecycle_mutex，[2 + f] 叉子 f；首次启用时分配，之后不再释放
+    std::unique_ptr<LockProfile[]> lock_profiles;
+    void reset_philosophers();
+    bool request_permission(int phil_id, int fork_id); // 调用方持有 state_mutex
+
+    // 叉子的获取与释放：在 state_mutex 内完成“策略检查 + 占用登记”，
+    // 使银行家算法的安全性检查与分配成为原子操作，并增量维护下面的持久状态
+    enum class AcquireResult { ACQUIRED, DENIED, BUSY };
+    AcquireResult try_acquire_fork(int phil_id, int fork_id, bool lock_mutex = true);
+    // 在叉子自身的互斥量上阻塞等待（不持有 state_mutex），拿到后再登记占用
+    void acquire_fork_blocking(int phil_id, int fork_id);
+    void register_holder(int phil_id, int fork_id); // 调用方持有 state_mutex
+    void release_fork(int phil_id, int fork_id, bool unlock_mutex = true);
+
     bool is_safe_state(int phil_id, int fork_id);
+
+    // 银行家算法的持久状态（受 state_mutex 保护）：available 即 forks[i]->holder == -1，
+    // banker_need[i] = 2 - 哲学家 i 当前持有的叉子数，随获取/释放增量更新
+    std::vector<int> left_fork_of;
+    std::vector<int> right_fork_of;
+    std::vector<int> banker_need;
+    bool banker_state_safe;          // 当前分配状态已知无等待环（非 BANKER 策略下的分配会使其失效）
+    std::vector<uint32_t> visit_mark; // 搜索用的访问标记（按 visit_epoch 区分各次搜索，无需清零）
+    uint32_t visit_epoch;
+    std::vector<int> search_stack;    // 预留容量为 N 的搜索栈，检查过程中不分配内存
+    // 叉子空间的位并行安全性内核，用于完整检查当前状态（banker_state_safe 失效时）
+    std::unique_ptr<BitsetSafetyChecker> safety_bits;
+
+    // 等待图（受 state_mutex 保护）：HUNGRY 的哲学家同一时刻只等待一把叉子，每人至多一条出边 i -> 持有者。
+    // 这里只保存由叉子持有情况决定的候选边，随叉子的获取/释放增量更新（只重算受影响的哲学家）；
+    // 状态切换不加锁，检测时再按“是否 HUNGRY”筛选，无需重建
+    std::vector<std::vector<int>> fork_users; // 需要每把叉子的哲学家
+    std::vector<int> wait_for;                // wait_for[i]：i 饥饿时所等叉子的持有者，-1 表示不会等待
+    std::vector<int> wait_fork;               // 对应的叉子编号
+    std::vector<uint64_t> wait_since_ns;      // 该候选边出现的时刻（单调时钟纳秒），用于计算检测延迟
+    // 等待图版本：候选边变化（持锁）或哲学家进入/离开 HUNGRY（不持锁）时加一，后台检测线程据此跳过未变化的图
+    std::atomic<uint64_t> wait_graph_version;
+    std::vector<int> detect_edges;            // detect_deadlock 的筛选结果与染色缓冲区
+    std::vector<int> detect_colour;
+    void update_wait_edge(int phil_id);
+    void update_wait_edges_of_fork(int fork_id);
+    void update_all_wait_edges();                     // 调用方持有 state_mutex
+    void collect_wait_edges(std::vector<int>& edges); // 调用方持有 state_mutex
+
+    // 后台死锁检测线程
+    std::unique_ptr<WinThread> detector_thread;
+    std::atomic<bool> detector_running;
+    WinSemaphore detector_wakeup;             // 停止时 post，使检测线程立即退出等待
+    int detector_interval_ms;
+    void deadlock_detector_thread();
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "win_sync.h"
+
+// 一个被发布字段（一位哲学家的状态或一把叉子的持有者）的槽位，嵌入写者自己的缓存行（PhilosopherRecord / Fork）。
+// 每个槽位是一个只有一个写者的小 seqlock：seq 为奇数表示正在写入，seq / 2 为写入次数。
+// saved_* 是本槽位在 saved_epoch 这个快照纪元中第一次被改写之前的值与写入次数，供该纪元的读者还原快照时刻的内容
+struct SnapshotSlot {
+    std::atomic<uint64_t> seq;
+    std::atomic<int32_t> value;
+    std::atomic<int32_t> saved_value;
+    std::atomic<uint64_t> saved_epoch;
+    std::atomic<uint64_t> saved_writes;
+
+    explicit SnapshotSlot(int initial)
+        : seq(0), value(initial), saved_value(initial), saved_epoch(0), saved_writes(0) {}
+
+    SnapshotSlot(const SnapshotSlot&) = delete;
+    SnapshotSlot& operator=(const SnapshotSlot&) = delete;
+};
+
+// 哲学家状态与叉子持有者的发布快照：写者只写自己的槽位，不同哲学家、不同叉子的写入互不共享缓存行，
+// 也没有全局的序号或 CAS；写者唯一读取的共享数据是快照纪元 epoch，它只在每次读取快照时改变一次。
+// 读者推进纪元，以此刻为快照时刻，再逐个槽位读取：槽位在新纪元中已被改写则取改写前保存的值，否则取当前值。
+// 写入按它读到的纪元划分到快照之前或之后；先发生的写入读到的纪元不会更大，因此这一划分是一致的切面，
+// 读者得到快照时刻全部字段的一致视图，字段再多、写入再频繁也不需要重试。
+// 读者从不阻塞写者：写者不等待任何人，读者只会在某个槽位正处于写入中（几条存储）时等待该槽位。
+// 读者之间由 read_mutex 串行化，同一时刻只有一个纪元在读取中。同一槽位的写者由调用方串行化
+// （状态只由哲学家自己的线程写入，持有者在 state_mutex 内写入）。字段均为原子量，没有数据竞争。
+class StateSnapshot {
+public:
+    StateSnapshot() : epoch(0) {}
+
+    StateSnapshot(const StateSnapshot&) = delete;
+    StateSnapshot& operator=(const StateSnapshot&) = delete;
+
+    void publish(SnapshotSlot& slot, int value) {
+        uint64_t s = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(s + 1, std::memory_order_relaxed);
+        // 奇数序号先于读取纪元：与 read 中推进纪元之后的栅栏配对，读者要么看到本次写入正在进行，
+        // 要么本次写入读到新纪元并保存旧值（同时也使奇数序号先于下面的字段写入可见）
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t e = epoch.load(std::memory_order_relaxed);
+        if (slot.saved_epoch.load(std::memory_order_relaxed) != e) {
+            slot.saved_value.store(slot.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            slot.saved_writes.store(s / 2, std::memory_order_relaxed);
+            slot.saved_epoch.store(e, std::memory_order_relaxed);
+        }
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.seq.store(s + 2, std::memory_order_release);
+    }
+
+    // 读取一致快照，返回对应的版本号（快照时刻全部槽位的写入次数之和，每次写入加一）。
+    // state_slot(i) / holder_slot(f) 返回第 i 位哲学家 / 第 f 把叉子的槽位
+    template<typename StateSlotAt, typename HolderSlotAt>
+    uint64_t read(int num_states, StateSlotAt&& state_slot, int num_holders, HolderSlotAt&& holder_slot,
+                  std::vector<int>& out_states, std::vector<int>& out_holders) const {
+        out_states.resize(num_states);
+        out_holders.resize(num_holders);
+        WinLockGuard lock(read_mutex);
+        uint64_t e = epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t version = 0;
+        for (int i = 0; i < num_states; ++i) out_states[i] = read_slot(state_slot(i), e, version);
+        for (int f = 0; f < num_holders; ++f) out_holders[f] = read_slot(holder_slot(f), e, version);
+        return version;
+    }
+
+private:
+    static const int SPINS_BEFORE_YIELD = 64;
+
+    static int read_slot(const SnapshotSlot& slot, uint64_t e, uint64_t& version) {
+        for (int attempt = 0;; ++attempt) {
+            uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+            if (s1 & 1) {
+                // 写者正在这个槽位内；它在快照之前读到旧纪元时必须等它写完，该写入属于快照
+                if (attempt >= SPINS_BEFORE_YIELD) std::this_thread::yield();
+                continue;
+            }
+            int value = slot.value.load(std::memory_order_relaxed);
+            int saved = slot.saved_value.load(std::memory_order_relaxed);
+            uint64_t saved_epoch = slot.saved_epoch.load(std::memory_order_relaxed);
+            uint64_t saved_writes = slot.saved_writes.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != s1) continue;
+            // 本纪元中已被改写：快照时刻的内容是第一次改写之前保存的值
+            if (saved_epoch == e) {
+                version += saved_writes;
+                return saved;
+            }
+            version += s1 / 2;
+            return value;
+        }
+    }
+
+    alignas(64) mutable std::atomic<uint64_t> epoch;
+    mutable WinMutex read_mutex;
+};
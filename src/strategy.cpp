@@ -0,0 +1,323 @@
+﻿#include "strategy.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+void DiningStrategy::release_forks(int phil_id, int left, int right) {
+    // 先释放右手再释放左手
+    release_fork(phil_id, right);
+    log_event(phil_id, EventKind::RELEASE, EventReason::RIGHT_FORK, right);
+    if (left == right) return;
+    release_fork(phil_id, left);
+    log_event(phil_id, EventKind::RELEASE, EventReason::LEFT_FORK, left);
+}
+
+bool TryLockStrategy::acquire_forks(int phil_id, int left, int right, std::mt19937& gen) {
+    BackoffPolicy& policy = backoff();
+    int attempt = 0;  // 本轮饥饿中退避的次数，决定退避时长
+    // 此前留下的通知与本轮无关（马上就会尝试获取），不丢弃的话第一次等待会立即返回，造成一次多余的重试
+    discard_wakeup(phil_id);
+    while (running()) {
+        // 先向系统请求是否允许获取左叉子（高层策略判断），通过后以 try_lock 非阻塞拿锁并登记占用
+        AcquireResult left_result = try_acquire_fork(phil_id, left);
+        if (left_result == AcquireResult::ACQUIRED) {
+            policy.record(left, true);
+            log_event(phil_id, EventKind::ACQUIRE, EventReason::LEFT_FORK, left);
+
+            // 小暂停模拟获取第二把叉子的延时（也能暴露出并发竞争）
+            sleep_for(phil_id, 10);
+
+            // 请求是否允许获取右叉子
+            AcquireResult right_result = try_acquire_fork(phil_id, right);
+            if (right_result == AcquireResult::ACQUIRED) {
+                policy.record(right, true);
+                log_event(phil_id, EventKind::ACQUIRE, EventReason::RIGHT_FORK, right);
+                return true;
+            } else if (right_result == AcquireResult::BUSY) {
+                // 未能拿到右叉子：回退（把左叉子放下）
+                policy.record(right, false);
+                release_fork(phil_id, left);
+                log_event(phil_id, EventKind::RELEASE, EventReason::LEFT_FORK_BACKOFF, left);
+            } else {
+                // 策略层拒绝分配右叉子，回退左叉子
+                release_fork(phil_id, left);
+                log_event(phil_id, EventKind::RELEASE, EventReason::LEFT_FORK_DENIED, left);
+            }
+            // 退避以打破相邻哲学家之间的对称、减少活锁竞争：这里是纯粹的延时，不因叉子释放而提前结束；
+            // 结束后直接重试左叉子，与状态机（虚拟时间、任务模式）的 TRY_RIGHT -> TRY_LEFT 相同
+            BackoffStep step = back_off(phil_id, BackoffSite::RIGHT_FORK_FAILED, right, attempt, gen);
+            if (step.action == BackoffStep::Action::SLEEP) sleep_for(phil_id, step.ms);
+            else policy.spin_or_yield(step);
+            continue;
+        }
+
+        if (left_result == AcquireResult::BUSY) policy.record(left, false);
+        // 左叉子被占用时，持有者释放它时一定会唤醒我们；被策略层拒绝（反饥饿礼让或银行家检查）时
+        // 不一定有叉子释放，等待时长由退避策略给出上限。被占用时的自旋只读发布的持有者，
+        // 看到叉子空闲才回到 try_acquire_fork，避免每轮自旋都去争 state_mutex
+        BackoffStep step = back_off(phil_id,
+                                    left_result == AcquireResult::BUSY ? BackoffSite::LEFT_FORK_BUSY
+                                                                       : BackoffSite::LEFT_FORK_DENIED,
+                                    left, attempt, gen);
+        if (step.action == BackoffStep::Action::SLEEP) wait_for_release(phil_id, step.ms);
+        else if (step.action == BackoffStep::Action::SPIN && left_result == AcquireResult::BUSY)
+            policy.spin_until(published_holder(left), -1);
+        else policy.spin_or_yield(step);
+    }
+    return false;
+}
+
+bool OrderedStrategy::acquire_forks(int phil_id, int left, int right, std::mt19937& /*gen*/) {
+    int first = std::min(left, right);
+    int second = std::max(left, right);
+
+    acquire_fork_blocking(phil_id, first);
+    log_event(phil_id, EventKind::ACQUIRE, first == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, first);
+    if (second != first) {
+        // 与 try-lock 策略相同的两把叉子之间的延时，便于比较吞吐量
+        sleep_for(phil_id, 10);
+        acquire_fork_blocking(phil_id, second);
+        log_event(phil_id, EventKind::ACQUIRE, second == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, second);
+    }
+
+    // 阻塞期间仿真可能已经停止，此时不再进餐
+    if (!running()) {
+        release_forks(phil_id, left, right);
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+int waiter_capacity(int n_phil, int n_forks) {
+    return std::max(1, std::min(n_phil, n_forks) - 1);
+}
+
+} // namespace
+
+WaiterStrategy::WaiterStrategy(Simulation& sim)
+    : DiningStrategy(sim),
+      seat_count(waiter_capacity(num_philosophers(), num_forks())),
+      seats(seat_count, seat_count) {}
+
+bool WaiterStrategy::acquire_forks(int phil_id, int left, int right, std::mt19937& /*gen*/) {
+    // 在信号量上阻塞等待空位，有人离席时被唤醒，不再 Sleep 轮询
+    seats.wait();
+    if (!running() || !is_active()) {
+        // 停止或策略切换后让出座位，唤醒下一位等待者，使所有等待的线程依次退出
+        seats.post();
+        return false;
+    }
+
+    int first = std::min(left, right);
+    int second = std::max(left, right);
+    acquire_fork_blocking(phil_id, first);
+    log_event(phil_id, EventKind::ACQUIRE, first == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, first);
+    if (second != first) {
+        acquire_fork_blocking(phil_id, second);
+        log_event(phil_id, EventKind::ACQUIRE, second == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, second);
+    }
+
+    if (!running()) {
+        release_forks(phil_id, left, right);
+        return false;
+    }
+    return true;
+}
+
+void WaiterStrategy::release_forks(int phil_id, int left, int right) {
+    DiningStrategy::release_forks(phil_id, left, right);
+    seats.post();
+}
+
+ChandyMisraStrategy::ChandyMisraStrategy(Simulation& sim)
+    : DiningStrategy(sim),
+      last_generation(0),
+      current(nullptr),
+      current_generation(0),
+      pinned(new std::atomic<uint64_t>[num_philosophers()]),
+      round_table(num_philosophers(), nullptr),
+      is_supported(true) {
+    for (int i = 0; i < num_philosophers(); ++i) pinned[i].store(UNPINNED, std::memory_order_relaxed);
+    for (int f = 0; f < num_forks(); ++f) {
+        if (fork_users(f).size() > 2) is_supported = false;
+    }
+}
+
+void ChandyMisraStrategy::prepare() {
+    int n = num_philosophers();
+    auto table = std::make_unique<SeatTable>();
+    for (int i = 0; i < n; ++i) table->push_back(std::make_unique<Seat>());
+
+    for (int i = 0; i < n; ++i) {
+        Seat& seat = *(*table)[i];
+        int left = left_fork_of(i);
+        int right = right_fork_of(i);
+        seat.sides = (left == right) ? 1 : 2;
+        seat.fork_id[0] = left;
+        seat.fork_id[1] = right;
+        for (int side = 0; side < seat.sides; ++side) {
+            const std::vector<int>& users = fork_users(seat.fork_id[side]);
+            int other = -1;
+            for (int u : users) {
+                if (u != i) other = u;
+            }
+            seat.neighbour[side] = other;
+            // 初始时叉子（脏）归编号较小的一方，令牌归另一方；独占的叉子始终在自己手中
+            seat.has_fork[side] = (other == -1 || i < other);
+            seat.has_token[side] = !seat.has_fork[side];
+            seat.dirty[side] = true;
+        }
+    }
+    // 先发布新的一套再发布其代号：读到新代号的哲学家随后一定取到新的一套（见 pin_current）
+    uint64_t generation = ++last_generation;
+    current.store(table.get(), std::memory_order_seq_cst);
+    current_generation.store(generation, std::memory_order_seq_cst);
+    tables.emplace_back(generation, std::move(table));
+
+    // 代号小于所有哲学家登记值的旧套已没有人访问，也不会再被取到（current 已指向新的一套）
+    uint64_t oldest_in_use = generation;
+    for (int i = 0; i < n; ++i) oldest_in_use = std::min(oldest_in_use, pinned[i].load(std::memory_order_seq_cst));
+    tables.erase(std::remove_if(tables.begin(), tables.end(),
+                                [&](const std::pair<uint64_t, std::unique_ptr<SeatTable>>& t) {
+                                    return t.first < oldest_in_use;
+                                }),
+                 tables.end());
+}
+
+ChandyMisraStrategy::SeatTable& ChandyMisraStrategy::pin_current(int phil_id) {
+    // 登记（seq_cst）先于读取 current：prepare 若没有看到这次登记，则其发布的新一套也已对这里的读取可见
+    pinned[phil_id].store(current_generation.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    return *current.load(std::memory_order_seq_cst);
+}
+
+void ChandyMisraStrategy::unpin(int phil_id) {
+    pinned[phil_id].store(UNPINNED, std::memory_order_release);
+}
+
+int ChandyMisraStrategy::side_of(const Seat& seat, int fork_id) const {
+    return (seat.fork_id[0] == fork_id) ? 0 : 1;
+}
+
+void ChandyMisraStrategy::send(SeatTable& table, int to, int fork_id, MessageKind kind) {
+    // 发给某位哲学家的消息只涉及它的至多两把叉子，每把叉子与其令牌在同一套状态中各只有一份，
+    // 所以同一信箱中至多 4 条消息，容量 8 的环形队列不会满
+    Seat& target = *table[to];
+    bool pushed = target.mailbox.try_push({fork_id, kind});
+    assert(pushed && "Chandy-Misra mailbox holds at most 4 messages");
+    (void)pushed;
+    target.doorbell.post();
+}
+
+void ChandyMisraStrategy::give_fork(SeatTable& table, int phil_id, int side) {
+    // 洗净后送出；令牌留在手中，之后饥饿时可凭它把叉子要回来
+    Seat& seat = *table[phil_id];
+    seat.has_fork[side] = false;
+    send(table, seat.neighbour[side], seat.fork_id[side], MessageKind::FORK);
+}
+
+void ChandyMisraStrategy::request_missing(SeatTable& table, int phil_id) {
+    Seat& seat = *table[phil_id];
+    if (!seat.hungry) return;
+    for (int side = 0; side < seat.sides; ++side) {
+        if (!seat.has_fork[side] && seat.has_token[side]) {
+            seat.has_token[side] = false;
+            send(table, seat.neighbour[side], seat.fork_id[side], MessageKind::REQUEST);
+        }
+    }
+}
+
+void ChandyMisraStrategy::serve_deferred(SeatTable& table, int phil_id) {
+    // 不再饥饿也不在进餐：交出所有被请求的叉子
+    Seat& seat = *table[phil_id];
+    for (int side = 0; side < seat.sides; ++side) {
+        if (seat.has_fork[side] && seat.has_token[side]) give_fork(table, phil_id, side);
+    }
+}
+
+void ChandyMisraStrategy::drain(SeatTable& table, int phil_id) {
+    Seat& seat = *table[phil_id];
+    Message msg;
+    while (seat.mailbox.try_pop(msg)) {
+        int side = side_of(seat, msg.fork_id);
+        if (msg.kind == MessageKind::FORK) {
+            seat.has_fork[side] = true;
+            seat.dirty[side] = false;  // 送来的叉子都是洗净的
+        } else {
+            seat.has_token[side] = true;
+            // 脏叉子必须交出；净叉子只在饥饿期间保留（它是刚要来的，交出会让自己白等）；进餐中一律推迟
+            bool keep = seat.eating || (seat.hungry && !seat.dirty[side]);
+            if (seat.has_fork[side] && !keep) give_fork(table, phil_id, side);
+        }
+    }
+    // 饥饿时把刚交出（或刚收到令牌）的叉子立即要回来
+    request_missing(table, phil_id);
+}
+
+bool ChandyMisraStrategy::acquire_forks(int phil_id, int left, int right, std::mt19937& /*gen*/) {
+    // 本轮绑定当前这套协议状态，进餐后按同一套归还
+    SeatTable& table = pin_current(phil_id);
+    round_table[phil_id] = &table;
+    Seat& seat = *table[phil_id];
+    seat.hungry = true;
+    drain(table, phil_id);
+    while (!(seat.has_fork[0] && seat.has_fork[seat.sides - 1])) {
+        // 策略被切换走（即使又切换回来，当前这套也已被替换）时放弃本轮
+        if (!running() || !is_active() || current.load(std::memory_order_acquire) != &table) {
+            seat.hungry = false;
+            serve_deferred(table, phil_id);
+            round_table[phil_id] = nullptr;
+            unpin(phil_id);
+            return false;
+        }
+        // 每等待 50ms 没有来信计一轮，与 try-lock 策略的重试间隔相当，供反饥饿统计使用
+        if (!timed_wait(phil_id, seat.doorbell, 50)) count_retry(phil_id);
+        drain(table, phil_id);
+    }
+    seat.hungry = false;
+    seat.eating = true;
+
+    // 协议保证两把叉子此时只在自己手中；仍按编号顺序锁住 Fork::mtx 并登记占用，
+    // 使资源图、等待图与银行家状态保持一致，与其他策略混用时也不会成环
+    int first = std::min(left, right);
+    int second = std::max(left, right);
+    acquire_fork_blocking(phil_id, first);
+    log_event(phil_id, EventKind::ACQUIRE, first == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, first);
+    if (second != first) {
+        acquire_fork_blocking(phil_id, second);
+        log_event(phil_id, EventKind::ACQUIRE, second == left ? EventReason::LEFT_FORK : EventReason::RIGHT_FORK, second);
+    }
+    return true;
+}
+
+void ChandyMisraStrategy::release_forks(int phil_id, int left, int right) {
+    DiningStrategy::release_forks(phil_id, left, right);
+    SeatTable& table = *round_table[phil_id];
+    Seat& seat = *table[phil_id];
+    seat.eating = false;
+    for (int side = 0; side < seat.sides; ++side) seat.dirty[side] = true;
+    drain(table, phil_id);
+    serve_deferred(table, phil_id);
+    round_table[phil_id] = nullptr;
+    unpin(phil_id);
+}
+
+void ChandyMisraStrategy::pause(int phil_id, DWORD ms) {
+    // 思考与进餐期间仍需响应邻居的请求：在信箱的门铃上限时等待，处理来信直到时间用完
+    // 使用当前这套状态：进餐期间若策略被切换走又切回，旧一套中的叉子不再有人索要，新一套中的请求照常响应。
+    // 进餐时本轮的登记值不大于当前这套的代号，已足以保护它；轮外（思考）的 pause 自行登记
+    bool in_round = round_table[phil_id] != nullptr;
+    if (!in_round) pin_current(phil_id);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (true) {
+        SeatTable& table = *current.load(std::memory_order_seq_cst);
+        drain(table, phil_id);
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        // 仿真停止后定时器服务不再计时，不必等满剩余时长
+        if (remaining <= 0 || !running()) break;
+        timed_wait(phil_id, table[phil_id]->doorbell, static_cast<DWORD>(remaining));
+    }
+    if (!in_round) unpin(phil_id);
+}
@@ -0,0 +1,178 @@
+﻿#pragma once
+#include <atomic>
+#include <random>
+#include <vector>
+#include <memory>
+#include "simulation.h"
+
+// 资源分配策略接口：philosopher_thread 在 HUNGRY 之后调用 acquire_forks 拿齐两把叉子，
+// 进餐结束后调用 release_forks 归还，思考与进餐的时长通过 pause 度过。permits 是 request_permission
+// 中的策略层检查（调用方持有 state_mutex），只有经过 try_acquire_fork 的获取才会用到它。
+// 策略对象由 Simulation 持有、所有哲学家线程共享，按哲学家区分的状态需按编号分别保存。
+class DiningStrategy {
+public:
+    explicit DiningStrategy(Simulation& sim) : sim(sim) {}
+    virtual ~DiningStrategy() = default;
+
+    DiningStrategy(const DiningStrategy&) = delete;
+    DiningStrategy& operator=(const DiningStrategy&) = delete;
+
+    // 拿齐 left / right 两把叉子后返回 true；仿真停止（或策略被切换）时放下已拿到的叉子并返回 false
+    virtual bool acquire_forks(int phil_id, int left, int right, std::mt19937& gen) = 0;
+    virtual void release_forks(int phil_id, int left, int right);
+    virtual void pause(int phil_id, DWORD ms) { sleep_for(phil_id, ms); }
+    virtual bool permits(int /*phil_id*/, int /*fork_id*/) { return true; }
+    // 只能在线程模式下运行的策略（阻塞式获取无法在单线程的虚拟时间模式中推进）
+    virtual bool threaded_only() const { return false; }
+
+protected:
+    // 只有基类是 Simulation 的友元，子类通过以下转发访问仿真内部
+    using AcquireResult = Simulation::AcquireResult;
+    bool running() const { return sim.running; }
+    bool is_active() { return &sim.active_strategy() == this; }
+    int num_philosophers() const { return sim.num_philosophers; }
+    int num_forks() const { return sim.num_forks; }
+    int left_fork_of(int phil_id) const { return sim.left_fork_of[phil_id]; }
+    int right_fork_of(int phil_id) const { return sim.right_fork_of[phil_id]; }
+    const std::vector<int>& fork_users(int fork_id) const { return sim.fork_users[fork_id]; }
+    Fork& fork(int fork_id) { return *sim.forks[fork_id]; }
+    AcquireResult try_acquire_fork(int phil_id, int fork_id) { return sim.try_acquire_fork(phil_id, fork_id); }
+    void acquire_fork_blocking(int phil_id, int fork_id) { sim.acquire_fork_blocking(phil_id, fork_id); }
+    void release_fork(int phil_id, int fork_id) { sim.release_fork(phil_id, fork_id); }
+    void log_event(int phil_id, EventKind kind, EventReason reason, int fork_id) {
+        sim.log_event(phil_id, kind, reason, fork_id);
+    }
+    // 哲学家线程的定时等待经由 Simulation 的定时器服务（set_timer_mode），不直接调用 Sleep
+    void sleep_for(int phil_id, DWORD ms) { sim.timed_sleep(phil_id, ms); }
+    bool timed_wait(int phil_id, WinSemaphore& sem, DWORD ms) { return sim.timed_wait(phil_id, sem, ms); }
+    // 在本哲学家的唤醒信号量上等待，直到某把所需叉子被释放、仿真停止或超时
+    void wait_for_release(int phil_id, DWORD timeout_ms) { timed_wait(phil_id, *sim.wakeups[phil_id], timeout_ms); }
+    // 丢弃唤醒信号量上残留的通知。release_fork 对所有饥饿的邻居都会 post，阻塞式策略（ORDERED、WAITER）
+    // 不在信号量上等待，通知会一直留着；停止时的 post 也会留到下次启动
+    void discard_wakeup(int phil_id) { sim.wakeups[phil_id]->try_wait(0); }
+    BackoffPolicy& backoff() { return sim.backoff; }
+    // 获取失败后的退避，与虚拟时间、任务模式的状态转换共用（见 Simulation::back_off）
+    BackoffStep back_off(int phil_id, BackoffSite site, int fork_id, int& attempt, std::mt19937& gen) {
+        return sim.back_off(phil_id, site, fork_id, attempt, gen);
+    }
+    // 叉子发布给监控的持有者（原子量，-1 表示空闲）：自旋时只读它，不拿 state_mutex
+    const std::atomic<int32_t>& published_holder(int fork_id) const { return sim.forks[fork_id]->published_holder.value; }
+    void count_retry(int phil_id) { sim.phils[phil_id].wait_count.fetch_add(1, std::memory_order_relaxed); }
+    bool is_safe_state(int phil_id, int fork_id) { return sim.is_safe_state(phil_id, fork_id); }
+
+    Simulation& sim;
+};
+
+// 原有的乐观获取：先左后右，每把叉子经 request_permission 许可后 try_lock，
+// 右叉子失败则放下左叉子退避；左叉子失败时等待该叉子被释放再试。
+// 退避与等待的时长由 BackoffPolicy 决定（默认 FIXED，见 backoff.h）（NONE 策略）
+class TryLockStrategy : public DiningStrategy {
+public:
+    using DiningStrategy::DiningStrategy;
+    bool acquire_forks(int phil_id, int left, int right, std::mt19937& gen) override;
+};
+
+// 银行家算法：获取流程与 TryLockStrategy 相同，许可检查时要求分配后状态仍然安全
+class BankerStrategy : public TryLockStrategy {
+public:
+    using TryLockStrategy::TryLockStrategy;
+    bool permits(int phil_id, int fork_id) override { return is_safe_state(phil_id, fork_id); }
+};
+
+// 资源有序分配（Dijkstra 层次法）：叉子按编号全序，每个哲学家总是先阻塞获取编号较小的一把，
+// 再获取较大的一把。等待链上的叉子编号严格递增，不可能成环，因此不需要许可检查、退避与重试
+class OrderedStrategy : public DiningStrategy {
+public:
+    using DiningStrategy::DiningStrategy;
+    bool acquire_forks(int phil_id, int left, int right, std::mt19937& gen) override;
+    bool threaded_only() const override { return true; }
+};
+
+// 服务员（仲裁者）策略：用计数信号量限制同时入座的人数，入座后阻塞获取叉子，不再需要 try-lock、退避与轮询。
+// 比例映射下等待环必须绕满整圈叉子，恰好涉及 M 位各持一把叉子的哲学家，N < M 时则根本无法成环，
+// 因此同时入座 min(N, M) - 1 人（至少 1 人）即可保证无死锁，且不限制可同时进餐的人数（至多 M/2）。
+// 入座后仍按叉子编号顺序加锁，使策略切换期间与其他阻塞式策略的哲学家混用时也不会成环
+class WaiterStrategy : public DiningStrategy {
+public:
+    explicit WaiterStrategy(Simulation& sim);
+    bool acquire_forks(int phil_id, int left, int right, std::mt19937& gen) override;
+    void release_forks(int phil_id, int left, int right) override;
+    bool threaded_only() const override { return true; }
+    int capacity() const { return seat_count; }
+
+private:
+    int seat_count;
+    WinSemaphore seats;
+};
+
+// Chandy–Misra 卫生哲学家算法：没有中心仲裁者，每把叉子由共享它的两位哲学家之一拥有，带脏/净标记，
+// 另一位持有该叉子的请求令牌。饥饿时把令牌发给对方索要叉子；收到请求时若叉子是脏的且自己没在进餐就洗净送出，
+// 净叉子（刚收到、尚未使用）在饥饿期间保留。进餐后叉子变脏，再交出积压的请求。
+// 初始时叉子归编号较小的哲学家且为脏，优先关系无环，因此无死锁且不会饿死。
+// 消息（请求令牌 / 叉子）通过每位哲学家的无锁信箱传递，信箱之外的协议状态只由哲学家自己的线程访问；
+// 思考与进餐期间也在 pause 中处理来信。要求每把叉子至多被两位哲学家共享（比例映射下即 N <= M）。
+class ChandyMisraStrategy : public DiningStrategy {
+public:
+    explicit ChandyMisraStrategy(Simulation& sim);
+    bool acquire_forks(int phil_id, int left, int right, std::mt19937& gen) override;
+    void release_forks(int phil_id, int left, int right) override;
+    void pause(int phil_id, DWORD ms) override;
+    bool threaded_only() const override { return true; }
+    // 当前的叉子映射是否满足“每把叉子至多两位使用者”
+    bool supported() const { return is_supported; }
+    // 每次切换到本策略时为每位哲学家建立一套全新的协议状态（调用方持有 state_mutex）。
+    // 上一次使用本策略时留下的叉子归属、令牌与信箱中的消息都属于旧的一套，不会被新一轮读到；
+    // 仍在旧一套上等待的哲学家发现当前这套已被替换后退出 acquire_forks。
+    // 同时回收已没有哲学家可能访问的旧套，反复切换时占用的内存不会增长。
+    // 不使用本策略的仿真（例如百万量级的任务模式）因此不必为每位哲学家分配信箱
+    void prepare();
+
+private:
+    enum class MessageKind : uint8_t { REQUEST, FORK };
+    struct Message {
+        int32_t fork_id;
+        MessageKind kind;
+    };
+
+    // 每位哲学家的协议状态，side 0 / 1 对应左 / 右叉子（左右为同一把时只用 side 0）
+    struct alignas(SIM_CACHE_LINE) Seat {
+        int sides;
+        int fork_id[2];
+        int neighbour[2];   // 共享该叉子的另一位哲学家，-1 表示独占
+        bool has_fork[2];
+        bool has_token[2];
+        bool dirty[2];      // 手中叉子的脏/净标记，随叉子消息转交（送出时洗净）
+        bool hungry;
+        bool eating;
+        // 每把叉子与每个令牌同一时刻只在一处，信箱中至多 4 条消息
+        MpscRing<Message> mailbox;
+        WinSemaphore doorbell;  // 投递后 post，等待来信时在其上阻塞
+
+        Seat() : sides(0), hungry(false), eating(false), mailbox(8), doorbell(0, 1) {}
+    };
+    // 一套协议状态：每次 prepare 新建一套，代号递增。旧的一套可能仍有哲学家在其上完成本轮，
+    // 要等到所有哲学家登记的代号（pinned）都大于它之后才由 prepare 回收
+    using SeatTable = std::vector<std::unique_ptr<Seat>>;
+    static const uint64_t UNPINNED = UINT64_MAX;
+
+    void send(SeatTable& table, int to, int fork_id, MessageKind kind);
+    void drain(SeatTable& table, int phil_id);
+    void give_fork(SeatTable& table, int phil_id, int side);
+    void request_missing(SeatTable& table, int phil_id);
+    void serve_deferred(SeatTable& table, int phil_id);
+    int side_of(const Seat& seat, int fork_id) const;
+    // 登记当前代号后取当前这套：此后取到的每一套代号都不小于登记值，在 unpin 之前不会被回收
+    SeatTable& pin_current(int phil_id);
+    void unpin(int phil_id);
+
+    // 尚未回收的各套状态及其代号，只在 prepare 中增删（受 state_mutex 保护）
+    std::vector<std::pair<uint64_t, std::unique_ptr<SeatTable>>> tables;
+    uint64_t last_generation;                         // 最近一次 prepare 分配的代号（受 state_mutex 保护）
+    std::atomic<SeatTable*> current;                  // 最近一次 prepare 建立的一套
+    std::atomic<uint64_t> current_generation;         // current 的代号，在 current 之后发布
+    // 每位哲学家可能访问的最老一套的代号，不在本策略的代码中时为 UNPINNED：
+    // 一轮从 acquire_forks 登记到 release_forks（或 acquire_forks 放弃）为止，轮外的 pause 各自登记
+    std::unique_ptr<std::atomic<uint64_t>[]> pinned;
+    std::vector<SeatTable*> round_table;              // 每位哲学家本轮拿叉子时所用的一套，只由其自己的线程访问
+    bool is_supported;
+};
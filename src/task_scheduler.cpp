@@ -0,0 +1,94 @@
+﻿#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+TaskScheduler::TaskScheduler(int num_tasks, int num_workers, StepFn step)
+    : num_tasks(num_tasks), step(std::move(step)), running(false), origin_ns(0) {
+    if (num_workers <= 0) {
+        num_workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int w = 0; w < num_workers; ++w) workers.push_back(std::make_unique<Worker>());
+}
+
+TaskScheduler::~TaskScheduler() {
+    stop();
+}
+
+uint64_t TaskScheduler::now_tick() const {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return static_cast<uint64_t>((ns - origin_ns) / 1000000);
+}
+
+void TaskScheduler::start() {
+    if (running) return;
+    origin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    // 工作线程尚未启动，此时由调用线程代为 push 是安全的（线程创建本身是同步点）
+    for (int t = 0; t < num_tasks; ++t) workers[t % workers.size()]->ready.push(t);
+    running = true;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        workers[w]->thread.start([this, w]() { worker_loop(static_cast<int>(w)); });
+    }
+}
+
+void TaskScheduler::stop() {
+    running = false;
+    for (auto& w : workers) w->wake.post();
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+bool TaskScheduler::steal(int self, int32_t& task, std::mt19937& gen) {
+    int n = num_workers();
+    if (n < 2) return false;
+    // 从随机位置开始轮询其他线程，避免所有空闲线程挤向同一个受害者
+    int start = std::uniform_int_distribution<>(0, n - 1)(gen);
+    for (int i = 0; i < n; ++i) {
+        int victim = (start + i) % n;
+        if (victim != self && workers[victim]->ready.steal(task)) return true;
+    }
+    return false;
+}
+
+void TaskScheduler::wake_idle_worker(int self) {
+    for (size_t w = 0; w < workers.size(); ++w) {
+        if (static_cast<int>(w) == self) continue;
+        bool expected = true;
+        if (workers[w]->idle.compare_exchange_strong(expected, false)) {
+            workers[w]->wake.post();
+            return;
+        }
+    }
+}
+
+void TaskScheduler::worker_loop(int self) {
+    Worker& me = *workers[self];
+    std::mt19937 gen(std::random_device{}() + self);
+
+    while (running) {
+        uint64_t now = now_tick();
+        int expired = 0;
+        me.timers.advance(now, [&](int32_t task) {
+            me.ready.push(task);
+            ++expired;
+        });
+        if (expired > 1) wake_idle_worker(self);
+
+        int32_t task;
+        if (me.ready.pop(task) || steal(self, task, gen)) {
+            long long delay = step(task, gen);
+            if (delay <= 0) me.ready.push(task);
+            else me.timers.schedule(task, now_tick() + static_cast<uint64_t>(delay));
+            continue;
+        }
+
+        // 没有可执行的任务：等到本线程的下一个定时器到期，或被其他线程唤醒来分担
+        uint64_t wait = std::min<uint64_t>(me.timers.ticks_until_next(), IDLE_WAIT_MS);
+        me.idle.store(true);
+        me.wake.try_wait(static_cast<DWORD>(wait));
+        me.idle.store(false);
+    }
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include "win_sync.h"
+#include "work_stealing_deque.h"
+#include "timer_wheel.h"
+
+// M:N 任务调度器：num_tasks 个以编号标识的任务在 num_workers 个工作线程上执行。
+// 任务是状态机，每次执行一步后返回下一步之前需要等待的毫秒数：0 表示立即再次就绪，放回本线程的双端队列；
+// 大于 0 时登记到本线程的分层时间轮（1ms 一个 tick），到期后成批进入本线程的队列。
+// 空闲的工作线程随机选择其他线程窃取任务，仍无事可做时在自己的信号量上等到下一个定时器到期；
+// 某线程一次有多个定时器到期时唤醒一个空闲线程来分担。任务的定时等待因此不占用线程，也不产生内核定时器
+class TaskScheduler {
+public:
+    // 执行任务 task 的一步，返回下一步之前的等待时长（毫秒）
+    using StepFn = std::function<long long(int task, std::mt19937& gen)>;
+
+    // num_workers <= 0 时使用硬件线程数
+    TaskScheduler(int num_tasks, int num_workers, StepFn step);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // 所有任务立即就绪（轮流分配给各工作线程），然后启动工作线程
+    void start();
+    // 通知工作线程退出并等待；正在执行的一步会执行完，之后不再执行任何任务
+    void stop();
+    int num_workers() const { return static_cast<int>(workers.size()); }
+
+private:
+    struct alignas(64) Worker {
+        WorkStealingDeque<int32_t> ready;
+        TimerWheel<int32_t> timers;
+        WinSemaphore wake;               // 空闲等待，二值
+        std::atomic<bool> idle;
+        WinThread thread;
+
+        Worker() : wake(0, 1), idle(false) {}
+    };
+
+    void worker_loop(int self);
+    bool steal(int self, int32_t& task, std::mt19937& gen);
+    void wake_idle_worker(int self);
+    uint64_t now_tick() const;
+
+    static const DWORD IDLE_WAIT_MS = 10;  // 无定时器时空闲等待的上限，兼顾偶尔漏掉的唤醒
+
+    int num_tasks;
+    StepFn step;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> running;
+    int64_t origin_ns;
+};
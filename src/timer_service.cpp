@@ -0,0 +1,116 @@
+﻿#include "timer_service.h"
+#include <algorithm>
+#include <chrono>
+
+TimerService::TimerService(int num_sleepers)
+    : pending(std::max(1024, 2 * num_sleepers)), next_wake(AWAKE), kick(0, 1), running(false), origin_ns(0) {
+    for (int i = 0; i < num_sleepers; ++i) sleepers.push_back(std::make_unique<Sleeper>());
+}
+
+TimerService::~TimerService() {
+    stop();
+}
+
+uint64_t TimerService::now_tick() const {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return static_cast<uint64_t>((ns - origin_ns) / 1000000);
+}
+
+void TimerService::start() {
+    if (running) return;
+    origin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    Alarm stale;
+    while (pending.try_pop(stale)) {}
+    wheel = TimerWheel<Alarm>(0);
+    next_wake = AWAKE;
+    running = true;
+    thread.start([this]() { service_loop(); });
+}
+
+void TimerService::stop() {
+    if (!running.exchange(false)) return;
+    kick.post();
+    if (thread.joinable()) thread.join();
+    // 唤醒仍在等待的线程：sleep 看到 running == false 后返回，wait 按超时返回。
+    // 登记方先发布 armed 再检查 running，与这里的先清 running 再读 armed 配对，不会漏掉正在登记的线程
+    for (auto& s : sleepers) {
+        uint32_t generation = s->armed.load();
+        WinSemaphore* target = s->target.load();
+        if (target == nullptr || s->fired.load() == generation) continue;
+        s->fired.store(generation, std::memory_order_release);
+        target->post();
+    }
+}
+
+TimerService::Armed TimerService::arm(int sleeper, WinSemaphore& target, DWORD ms, uint32_t& generation) {
+    Sleeper& s = *sleepers[sleeper];
+    generation = s.armed.load(std::memory_order_relaxed) + 1;
+    s.target.store(&target, std::memory_order_relaxed);
+    s.armed.store(generation);
+    if (!running) return Armed::STOPPED;
+    uint64_t deadline = now_tick() + std::max<DWORD>(ms, 1);
+    if (!pending.try_push({sleeper, generation, deadline, &target})) {
+        s.armed.store(generation + 1, std::memory_order_relaxed);
+        return Armed::QUEUE_FULL;
+    }
+    // 服务线程按当时最早的定时器决定睡多久，更早的登记需要唤醒它（与 service_loop 中的栅栏配对）
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t planned = next_wake.load(std::memory_order_relaxed);
+    if (planned != AWAKE && deadline < planned) kick.post();
+    return Armed::OK;
+}
+
+void TimerService::sleep(int sleeper, DWORD ms) {
+    if (ms == 0) return;
+    Sleeper& s = *sleepers[sleeper];
+    uint32_t generation;
+    Armed armed = arm(sleeper, s.alarm, ms, generation);
+    if (armed == Armed::QUEUE_FULL) Sleep(ms);
+    if (armed != Armed::OK) return;
+    // 上一次遗留的 post 可能使信号量提前可用，按代号确认确实到期
+    while (s.fired.load(std::memory_order_acquire) != generation && running) s.alarm.wait();
+}
+
+bool TimerService::wait(int sleeper, WinSemaphore& sem, DWORD ms) {
+    if (ms == 0) return sem.try_wait(0);
+    Sleeper& s = *sleepers[sleeper];
+    uint32_t generation;
+    Armed armed = arm(sleeper, sem, ms, generation);
+    if (armed == Armed::QUEUE_FULL) return sem.try_wait(ms);
+    if (armed == Armed::STOPPED) return sem.try_wait(0);
+    sem.wait();
+    if (s.fired.load(std::memory_order_acquire) == generation) return false;
+    // 被其他线程 post：作废仍在时间轮中的定时器（它到期时若已读到旧代号，至多多 post 一次，调用方都能容忍）
+    s.armed.compare_exchange_strong(generation, generation + 1);
+    return true;
+}
+
+void TimerService::service_loop() {
+    while (running) {
+        uint64_t now = now_tick();
+        Alarm alarm;
+        while (pending.try_pop(alarm)) wheel.schedule(alarm, alarm.deadline);
+        wheel.advance(now, [&](const Alarm& a) {
+            Sleeper& s = *sleepers[a.sleeper];
+            if (s.armed.load(std::memory_order_relaxed) != a.generation) return;
+            s.fired.store(a.generation, std::memory_order_release);
+            due.push_back(a.target);
+        });
+        // 同一 tick 到期的等待者成批唤醒
+        for (WinSemaphore* sem : due) sem->post();
+        due.clear();
+
+        uint64_t ticks = std::min<uint64_t>(wheel.ticks_until_next(), IDLE_WAIT_MS);
+        next_wake.store(now + ticks);
+        // 公布计划后再检查一次队列：登记方要么在这里被看到，要么看到新的 next_wake 并唤醒服务线程
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending.try_pop(alarm)) {
+            wheel.schedule(alarm, alarm.deadline);
+        } else {
+            kick.try_wait(static_cast<DWORD>(ticks));
+        }
+        next_wake.store(AWAKE);
+    }
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "win_sync.h"
+#include "mpsc_ring.h"
+#include "timer_wheel.h"
+
+// 共享定时器服务：线程模式下所有哲学家的定时等待登记到同一个分层时间轮（timer_wheel.h，1ms 一个 tick），
+// 由一个服务线程推进，每个 tick 把到期的等待者成批唤醒。哲学家线程只在信号量上无超时阻塞，
+// 不再各自持有一个内核定时器（Sleep / 带超时的等待），N 很大时服务线程每个 tick 只醒来一次。
+// 登记经由无锁 MPSC 队列交给服务线程，时间轮只由服务线程访问，登记与推进之间没有锁。
+// 等待者以编号标识（0 .. num_sleepers-1），同一编号同一时刻只能由一个线程等待
+class TimerService {
+public:
+    explicit TimerService(int num_sleepers);
+    ~TimerService();
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    void start();
+    // 停止服务线程并唤醒所有正在等待的线程（wait 视为超时）；此后的 sleep / wait 立即返回
+    void stop();
+
+    // 阻塞 ms 毫秒（按 tick 取整），服务停止时提前返回
+    void sleep(int sleeper, DWORD ms);
+    // 在 sem 上等待至多 ms 毫秒：到期时由服务线程代为 post。sem 被其他线程 post 时返回 true，超时返回 false。
+    // 服务未运行时退化为 sem.try_wait(0)
+    bool wait(int sleeper, WinSemaphore& sem, DWORD ms);
+
+private:
+    struct Alarm {
+        int32_t sleeper;
+        uint32_t generation;
+        uint64_t deadline;
+        WinSemaphore* target;  // 到期时 post 的信号量
+    };
+
+    struct alignas(64) Sleeper {
+        std::atomic<uint32_t> armed;   // 最近一次登记的代号，过期（已提前返回）的定时器按代号忽略
+        std::atomic<uint32_t> fired;   // 最近一次到期（或被 stop 唤醒）的代号
+        std::atomic<WinSemaphore*> target;
+        WinSemaphore alarm;            // sleep 使用的信号量，二值
+
+        Sleeper() : armed(0), fired(0), target(nullptr), alarm(0, 1) {}
+    };
+
+    enum class Armed { OK, STOPPED, QUEUE_FULL };
+    // 登记 sleeper 在 ms 毫秒后 post target
+    Armed arm(int sleeper, WinSemaphore& target, DWORD ms, uint32_t& generation);
+    void service_loop();
+    uint64_t now_tick() const;
+
+    static const DWORD IDLE_WAIT_MS = 100;  // 没有定时器时服务线程空闲等待的上限
+    static const uint64_t AWAKE = 0;        // next_wake 的取值之一：服务线程正在运行，登记无需唤醒它
+
+    std::vector<std::unique_ptr<Sleeper>> sleepers;
+    MpscRing<Alarm> pending;                // 尚未放入时间轮的登记；队列满时该次等待退回内核定时器
+    TimerWheel<Alarm> wheel;                // 只由服务线程访问
+    std::atomic<uint64_t> next_wake;        // 服务线程计划醒来的 tick，更早的登记需唤醒它
+    std::vector<WinSemaphore*> due;         // 本 tick 到期的信号量（只由服务线程访问）
+    WinSemaphore kick;
+    std::atomic<bool> running;
+    WinThread thread;
+    int64_t origin_ns;
+};
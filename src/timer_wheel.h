@@ -0,0 +1,107 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// 分层时间轮（Varghese & Lauck，Linux 内核 timer wheel 的结构）：LEVELS 层、每层 64 个槽，
+// 第 k 层的一个槽覆盖 64^k 个 tick。定时器按到期时间与当前时间之差放入能容纳它的最低一层，
+// 低层转完一圈时把上一层对应槽中的定时器重新分配到下层。登记为 O(1)，推进每个 tick 摊还 O(1)，
+// 与定时器数量无关；超出最高层范围（64^4 tick）的定时器暂存在最高层，级联时再重新放置。
+// 不是线程安全的：由单个线程拥有，或由调用方加锁。
+template<typename T>
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t start_tick = 0) : current(start_tick), count(0) {}
+
+    uint64_t now() const { return current; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // 登记在 deadline_tick 到期的定时器；不晚于当前 tick 的视为下一个 tick 到期
+    void schedule(const T& item, uint64_t deadline_tick) {
+        if (deadline_tick <= current) deadline_tick = current + 1;
+        place({item, deadline_tick});
+        ++count;
+    }
+
+    // 推进到 now_tick，对每个到期的定时器调用 on_expire(item)（同一 tick 内按登记顺序）
+    template<typename F>
+    void advance(uint64_t now_tick, F&& on_expire) {
+        if (count == 0) {
+            if (now_tick > current) current = now_tick;
+            return;
+        }
+        while (current < now_tick) {
+            ++current;
+            // 先级联高层：上一层的定时器可能落入本 tick 的下层槽位
+            for (int level = LEVELS - 1; level >= 1; --level) {
+                if ((current & ((uint64_t(1) << (BITS * level)) - 1)) == 0) cascade(level);
+            }
+            std::vector<Entry>& slot = slots[0][current & MASK];
+            if (slot.empty()) continue;
+            expiring.swap(slot);
+            for (const Entry& e : expiring) {
+                if (e.deadline <= current) {
+                    --count;
+                    on_expire(e.item);
+                } else {
+                    place(e);  // 超出范围而暂存的定时器
+                }
+            }
+            expiring.clear();
+            if (count == 0) {
+                current = now_tick;
+                return;
+            }
+        }
+    }
+
+    // 距下一次可能有定时器到期还有多少个 tick（上界，用于决定空闲时可以等待多久）；没有定时器时返回最大值
+    uint64_t ticks_until_next() const {
+        if (count == 0) return std::numeric_limits<uint64_t>::max();
+        for (uint64_t d = 1; d < SLOTS; ++d) {
+            if (!slots[0][(current + d) & MASK].empty()) return d;
+        }
+        // 第 0 层为空：下一次级联发生在第 0 层转完一圈时
+        return SLOTS - (current & MASK);
+    }
+
+private:
+    static const int BITS = 6;
+    static const int LEVELS = 4;
+    static const uint64_t SLOTS = uint64_t(1) << BITS;
+    static const uint64_t MASK = SLOTS - 1;
+
+    struct Entry {
+        T item;
+        uint64_t deadline;
+    };
+
+    void place(const Entry& e) {
+        uint64_t delta = e.deadline - current;
+        for (int level = 0; level < LEVELS; ++level) {
+            if (delta < (uint64_t(1) << (BITS * (level + 1)))) {
+                slots[level][(e.deadline >> (BITS * level)) & MASK].push_back(e);
+                return;
+            }
+        }
+        // 超出范围：放在最高层中最晚被级联的槽位
+        int top = LEVELS - 1;
+        slots[top][((current >> (BITS * top)) - 1) & MASK].push_back(e);
+    }
+
+    void cascade(int level) {
+        std::vector<Entry>& slot = slots[level][(current >> (BITS * level)) & MASK];
+        if (slot.empty()) return;
+        cascading.swap(slot);
+        for (const Entry& e : cascading) place(e);
+        cascading.clear();
+    }
+
+    uint64_t current;  // 已处理到的 tick
+    size_t count;
+    std::vector<Entry> slots[LEVELS][SLOTS];
+    std::vector<Entry> expiring;   // 复用的临时缓冲，避免每个 tick 分配内存
+    std::vector<Entry> cascading;
+};
@@ -0,0 +1,131 @@
+﻿#include "trace_recorder.h"
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> next_recorder_id{1};
+
+const char* name_of(TraceName name) {
+    switch (name) {
+    case TraceName::THINKING:         return "THINKING";
+    case TraceName::HUNGRY:           return "HUNGRY";
+    case TraceName::EATING:           return "EATING";
+    case TraceName::ACQUIRE_FORK:     return "acquire fork";
+    case TraceName::RELEASE_FORK:     return "release fork";
+    case TraceName::WAIT_FORK:        return "wait fork";
+    case TraceName::WAIT_STATE_MUTEX: return "wait state_mutex";
+    }
+    return "?";
+}
+
+const char* category_of(TraceName name) {
+    switch (name) {
+    case TraceName::THINKING:
+    case TraceName::HUNGRY:
+    case TraceName::EATING:           return "state";
+    case TraceName::ACQUIRE_FORK:
+    case TraceName::RELEASE_FORK:     return "fork";
+    case TraceName::WAIT_FORK:
+    case TraceName::WAIT_STATE_MUTEX: break;
+    }
+    return "lock";
+}
+
+// chrome://tracing 的保留配色名（Perfetto 忽略该字段，按名称着色）
+const char* colour_of(TraceName name) {
+    switch (name) {
+    case TraceName::THINKING: return "grey";
+    case TraceName::HUNGRY:   return "bad";
+    case TraceName::EATING:   return "good";
+    default:                  break;
+    }
+    return "terrible";
+}
+
+bool is_instant(TraceName name) {
+    return name == TraceName::ACQUIRE_FORK || name == TraceName::RELEASE_FORK;
+}
+
+// 以微秒为单位、保留纳秒精度输出时间戳，不经过浮点数
+void print_us(FILE* out, uint64_t ns) {
+    std::fprintf(out, "%llu.%03u", static_cast<unsigned long long>(ns / 1000), static_cast<unsigned>(ns % 1000));
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder(uint64_t origin_ns, size_t max_events_per_thread)
+    : id(next_recorder_id.fetch_add(1, std::memory_order_relaxed)),
+      origin_ns(origin_ns),
+      max_events_per_thread(max_events_per_thread) {}
+
+TraceRecorder::Buffer& TraceRecorder::local_buffer() {
+    // 每个线程缓存最近一次使用的记录器及其缓冲区；换用另一个记录器（例如同一线程先后运行多个仿真）时重新登记
+    struct Cache {
+        uint64_t owner = 0;
+        Buffer* buffer = nullptr;
+    };
+    thread_local Cache cache;
+    if (cache.owner != id) {
+        auto buffer = std::make_unique<Buffer>();
+        cache.buffer = buffer.get();
+        cache.owner = id;
+        WinLockGuard lock(buffers_mutex);
+        buffers.push_back(std::move(buffer));
+    }
+    return *cache.buffer;
+}
+
+void TraceRecorder::append(int phil_id, TraceName name, uint64_t ts_ns, uint64_t dur_ns, int fork_id) {
+    Buffer& b = local_buffer();
+    if (b.size >= max_events_per_thread) {
+        b.dropped++;
+        return;
+    }
+    size_t offset = b.size % CHUNK_RECORDS;
+    if (offset == 0) b.chunks.push_back(std::unique_ptr<Record[]>(new Record[CHUNK_RECORDS]));
+    b.chunks.back()[offset] = Record{ts_ns, dur_ns, phil_id, fork_id, name};
+    b.size++;
+}
+
+bool TraceRecorder::write(const std::string& path, int num_philosophers) const {
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    WinLockGuard lock(buffers_mutex);
+    std::vector<char> seen(num_philosophers, 0);
+    uint64_t dropped_total = 0;
+    std::fputs("{\"traceEvents\":[\n", out);
+    std::fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"dining philosophers\"}}",
+               out);
+    for (const auto& b : buffers) {
+        dropped_total += b->dropped;
+        for (size_t i = 0; i < b->size; ++i) {
+            const Record& r = b->chunks[i / CHUNK_RECORDS][i % CHUNK_RECORDS];
+            if (r.phil_id >= 0 && r.phil_id < num_philosophers) seen[r.phil_id] = 1;
+            // 记录器创建之前的时刻（例如上一次运行遗留的状态起点）截到零点
+            uint64_t ts = (r.ts_ns > origin_ns) ? r.ts_ns - origin_ns : 0;
+            std::fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":",
+                         name_of(r.name), category_of(r.name), r.phil_id);
+            print_us(out, ts);
+            if (is_instant(r.name)) {
+                std::fputs(",\"ph\":\"i\",\"s\":\"t\"", out);
+            } else {
+                std::fputs(",\"ph\":\"X\",\"dur\":", out);
+                print_us(out, r.dur_ns);
+                std::fprintf(out, ",\"cname\":\"%s\"", colour_of(r.name));
+            }
+            if (r.fork_id >= 0) std::fprintf(out, ",\"args\":{\"fork\":%d}", r.fork_id);
+            std::fputs("}", out);
+        }
+    }
+    // 只为出现过的哲学家命名，百万量级的任务模式下未被记录的哲学家不占用时间线
+    for (int i = 0; i < num_philosophers; ++i) {
+        if (!seen[i]) continue;
+        std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Phil %d\"}}",
+                     i, i);
+    }
+    std::fprintf(out, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":%llu}}\n",
+                 static_cast<unsigned long long>(dropped_total));
+    bool ok = !std::ferror(out);
+    return std::fclose(out) == 0 && ok;
+}
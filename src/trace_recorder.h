@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "win_sync.h"
+
+// 追踪记录的名称：前三个与 State 的取值一一对应（状态区间），其余为叉子的获取 / 释放瞬时事件与锁等待区间
+enum class TraceName : uint8_t {
+    THINKING, HUNGRY, EATING,
+    ACQUIRE_FORK, RELEASE_FORK,
+    WAIT_FORK, WAIT_STATE_MUTEX
+};
+
+// 仿真时间线的追踪记录器，导出为 Chrome Trace Event JSON（chrome://tracing 与 ui.perfetto.dev 均可打开）。
+// 每个记录线程第一次写入时登记一个私有缓冲区，之后的写入只追加到自己的缓冲区，不加锁也不与其他线程共享缓存行；
+// 缓冲区按固定大小的块增长，不会因整体搬迁而在时间线上留下停顿。每个线程最多保存 max_events_per_thread 条，
+// 超出的记录丢弃并计数。write 在所有记录线程停止后由调用方调用（Simulation::stop 与 run_virtual 结束时）。
+// 时间线上每位哲学家是一行（tid 为哲学家编号），与实际执行的线程无关，任务模式下同样按哲学家展示
+class TraceRecorder {
+public:
+    // origin_ns 为时间线的零点（与记录使用同一时钟）
+    TraceRecorder(uint64_t origin_ns, size_t max_events_per_thread);
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // 区间 [begin_ns, begin_ns + dur_ns)，fork_id 为 -1 时不附带叉子编号
+    void span(int phil_id, TraceName name, uint64_t begin_ns, uint64_t dur_ns, int fork_id = -1) {
+        append(phil_id, name, begin_ns, dur_ns, fork_id);
+    }
+    void instant(int phil_id, TraceName name, uint64_t ts_ns, int fork_id) {
+        append(phil_id, name, ts_ns, 0, fork_id);
+    }
+
+    // 写出全部缓冲区，无法写入文件时返回 false
+    bool write(const std::string& path, int num_philosophers) const;
+
+private:
+    struct Record {
+        uint64_t ts_ns;
+        uint64_t dur_ns;
+        int32_t phil_id;
+        int32_t fork_id;
+        TraceName name;
+    };
+
+    static const size_t CHUNK_RECORDS = 4096;
+
+    struct Buffer {
+        std::vector<std::unique_ptr<Record[]>> chunks;
+        size_t size = 0;
+        uint64_t dropped = 0;
+    };
+
+    void append(int phil_id, TraceName name, uint64_t ts_ns, uint64_t dur_ns, int fork_id);
+    Buffer& local_buffer();
+
+    const uint64_t id;  // 区分不同的记录器，使线程局部的缓冲区缓存不会指向已销毁的记录器
+    const uint64_t origin_ns;
+    const size_t max_events_per_thread;
+    mutable WinMutex buffers_mutex;  // 只在线程登记缓冲区与 write 时使用
+    std::vector<std::unique_ptr<Buffer>> buffers;
+};
@@ -2,7 +2,7 @@
 #include <stdexcept>
 
 // WinMutex ʵ
-WinMutex::WinMutex() {
+WinMutex::WinMutex() : profile(nullptr), held_profile(nullptr), held_depth(0), hold_since_ns(0) {
     InitializeCriticalSection(&cs);
 }
 
@@ -10,15 +10,15 @@ WinMutex::~WinMutex() {
     DeleteCriticalSection(&cs);
 }
 
-void WinMutex::lock() {
+void WinMutex::raw_lock() {
     EnterCriticalSection(&cs);
 }
 
-bool WinMutex::try_lock() {
+bool WinMutex::raw_try_lock() {
     return TryEnterCriticalSection(&cs) != 0;
 }
 
-void WinMutex::unlock() {
+void WinMutex::raw_unlock() {
     LeaveCriticalSection(&cs);
 }
 
@@ -4,27 +4,99 @@
 #include <windows.h>
 #include <process.h>
 #else
-#error "This file is only for Windows platform"
+#include <pthread.h>
+#include <cstdint>
 #endif
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <mutex>
+
+#ifndef _WIN32
+// POSIX ƽ̨÷ʹõ Windows  Sleepʹ simulation ޸
+typedef uint32_t DWORD;
+#ifndef INFINITE
+#define INFINITE 0xFFFFFFFFu
+#endif
+void Sleep(DWORD ms);
+#endif
+
+struct LockProfile;
 
 // װ Windows CRITICAL_SECTIONṩ RAII 
+// POSIX ƽ̨ pthread_mutexݹ飩 Linux futex ʵ֣ CRITICAL_SECTION һ£룩
+// ѡset_profile ֮ÿΣ㣩¼ȡǷáȴʱ lock_profile.h
+// δʱ lock / unlock ֻһԭӶȡһγֶεļ
 class WinMutex {
 public:
     WinMutex();
     ~WinMutex();
 
-    void lock();
-    bool try_lock();
-    void unlock();
+    void lock() {
+        LockProfile* p = profile.load(std::memory_order_relaxed);
+        if (p != nullptr) {
+            lock_measured(p);
+            return;
+        }
+        raw_lock();
+        // ֶֻɳ̶߳дǿ˵߳ги룩
+        if (held_profile != nullptr) ++held_depth;
+    }
+
+    bool try_lock() {
+        LockProfile* p = profile.load(std::memory_order_relaxed);
+        if (!raw_try_lock()) {
+            if (p != nullptr) note_failed_try(p);
+            return false;
+        }
+        if (held_profile != nullptr) ++held_depth;
+        else if (p != nullptr) begin_hold(p, false, 0);
+        return true;
+    }
+
+    void unlock() {
+        if (held_profile != nullptr && --held_depth == 0) end_hold();
+        raw_unlock();
+    }
+
+    //  lock ͬʱͬΪһλȡصȴδʱΪ 0 Ҳʱӡ
+    // Ҫм¼ȴʱĵ÷ʱ׷٣ʹã try_lock һ
+    uint64_t lock_and_measure() { return lock_measured(profile.load(std::memory_order_relaxed)); }
+
+    // ã nullptr ȡͳƶ󣻿ʹʱлڳеһΰʱý
+    void set_profile(LockProfile* p) { profile.store(p, std::memory_order_relaxed); }
 
     WinMutex(const WinMutex&) = delete;
     WinMutex& operator=(const WinMutex&) = delete;
 
 private:
+    // ƽ̨˵ʵ֣win_sync.cpp / win_sync_posix.cpp
+    void raw_lock();
+    bool raw_try_lock();
+    void raw_unlock();
+
+    // ·lock_profile.cpp
+    uint64_t lock_measured(LockProfile* p);  // p Ϊ nullptr ʱֻ
+    void begin_hold(LockProfile* p, bool contended, uint64_t waited_ns);
+    void end_hold();
+    static void note_failed_try(LockProfile* p);
+
+    std::atomic<LockProfile*> profile;
+    LockProfile* held_profile; // γмͳƶֻɳ߷
+    int held_depth;            // гʱ
+    uint64_t hold_since_ns;
+
+#ifdef _WIN32
     CRITICAL_SECTION cs;
+#elif defined(SIM_SYNC_FUTEX)
+    // futex ֣0 = δ1 = Ѽ޵ȴߣ2 = Ѽҿеȴ
+    std::atomic<int> word;
+    std::atomic<long> owner; // ߳ id0 ʾޣʵֿ
+    int recursion;
+#else
+    pthread_mutex_t mtx;
+#endif
 };
 
 // װ RAII 
@@ -33,6 +105,8 @@ public:
     explicit WinLockGuard(WinMutex& m) : mutex(m) {
         mutex.lock();
     }
+    // ӹܵ÷Ѿеֻʱ
+    WinLockGuard(WinMutex& m, std::adopt_lock_t) : mutex(m) {}
     ~WinLockGuard() {
         mutex.unlock();
     }
@@ -58,31 +132,56 @@ public:
     WinSemaphore& operator=(const WinSemaphore&) = delete;
 
 private:
+#ifdef _WIN32
     HANDLE handle;
+#elif defined(SIM_SYNC_FUTEX)
+    std::atomic<int> count;   // futex ֣ǰü
+    std::atomic<int> waiters; //  futex ϵȴ߳Ϊ 0 ʱ post ȥϵͳ
+    long max_count;
+#else
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    long count;
+    long max_count;
+#endif
 };
 
 // װ Windows ߳
 class WinThread {
 public:
+#ifdef _WIN32
     WinThread() : handle(NULL) {}
+#else
+    WinThread() : handle(), started(false) {}
+#endif
     ~WinThread();
 
     // ̣߳뺯
     template<typename Func>
     void start(Func&& func) {
         auto* wrapper = new std::function<void()>(std::forward<Func>(func));
+#ifdef _WIN32
         handle = (HANDLE)_beginthreadex(
             NULL, 0, thread_proc, wrapper, 0, NULL
         );
+#else
+        started = pthread_create(&handle, NULL, thread_proc, wrapper) == 0;
+        if (!started) delete wrapper;
+#endif
     }
 
     void join();
+#ifdef _WIN32
     bool joinable() const { return handle != NULL; }
+#else
+    bool joinable() const { return started; }
+#endif
 
     WinThread(const WinThread&) = delete;
     WinThread& operator=(const WinThread&) = delete;
 
 private:
+#ifdef _WIN32
     HANDLE handle;
 
     static unsigned int __stdcall thread_proc(void* arg) {
@@ -91,4 +190,15 @@ private:
         delete func;
         return 0;
     }
+#else
+    pthread_t handle;
+    bool started;
+
+    static void* thread_proc(void* arg) {
+        auto* func = static_cast<std::function<void()>*>(arg);
+        (*func)();
+        delete func;
+        return NULL;
+    }
+#endif
 };
@@ -0,0 +1,271 @@
+﻿#include "win_sync.h"
+#include <stdexcept>
+#include <cerrno>
+#include <ctime>
+
+// POSIX 平台实现：与 win_sync.cpp 提供相同的接口与语义。
+// 默认使用 pthread；在 Linux 上以 SIM_SYNC_BACKEND=futex 配置时，WinMutex / WinSemaphore 直接基于 futex 系统调用实现。
+
+#ifdef SIM_SYNC_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+namespace {
+
+int* futex_addr(std::atomic<int>& word) {
+    return reinterpret_cast<int*>(&word);
+}
+
+// 若 *addr == expected 则睡眠，timeout 为 NULL 表示无限等待
+long futex_wait(std::atomic<int>& word, int expected, const timespec* timeout) {
+    return syscall(SYS_futex, futex_addr(word), FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+void futex_wake(std::atomic<int>& word, int count) {
+    syscall(SYS_futex, futex_addr(word), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// 当前线程 id，缓存在线程局部变量中以免每次加锁都进入内核
+long current_thread_id() {
+    thread_local long tid = static_cast<long>(syscall(SYS_gettid));
+    return tid;
+}
+
+} // namespace
+#endif
+
+namespace {
+
+timespec monotonic_now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts;
+}
+
+timespec add_ms(timespec ts, DWORD ms) {
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += static_cast<long>(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+} // namespace
+
+// Sleep 实现（毫秒），被信号打断时继续睡完剩余时间
+void Sleep(DWORD ms) {
+    timespec req;
+    req.tv_sec = ms / 1000;
+    req.tv_nsec = static_cast<long>(ms % 1000) * 1000000L;
+    while (nanosleep(&req, &req) == -1 && errno == EINTR) {
+    }
+}
+
+#ifdef SIM_SYNC_FUTEX
+
+// WinMutex 实现（futex，三态锁：见 Drepper《Futexes Are Tricky》）
+WinMutex::WinMutex()
+    : profile(nullptr), held_profile(nullptr), held_depth(0), hold_since_ns(0), word(0), owner(0), recursion(0) {}
+
+WinMutex::~WinMutex() {}
+
+void WinMutex::raw_lock() {
+    long self = current_thread_id();
+    if (owner.load(std::memory_order_relaxed) == self) {
+        ++recursion;
+        return;
+    }
+    int c = 0;
+    if (!word.compare_exchange_strong(c, 1, std::memory_order_acquire)) {
+        // 竞争路径：标记为“有等待者”后睡眠，直到成功以 2 状态拿到锁
+        if (c != 2) c = word.exchange(2, std::memory_order_acquire);
+        while (c != 0) {
+            futex_wait(word, 2, NULL);
+            c = word.exchange(2, std::memory_order_acquire);
+        }
+    }
+    owner.store(self, std::memory_order_relaxed);
+    recursion = 1;
+}
+
+bool WinMutex::raw_try_lock() {
+    long self = current_thread_id();
+    if (owner.load(std::memory_order_relaxed) == self) {
+        ++recursion;
+        return true;
+    }
+    int c = 0;
+    if (!word.compare_exchange_strong(c, 1, std::memory_order_acquire)) return false;
+    owner.store(self, std::memory_order_relaxed);
+    recursion = 1;
+    return true;
+}
+
+void WinMutex::raw_unlock() {
+    if (--recursion > 0) return;
+    owner.store(0, std::memory_order_relaxed);
+    if (word.exchange(0, std::memory_order_release) == 2) {
+        futex_wake(word, 1);
+    }
+}
+
+// WinSemaphore 实现（futex）
+WinSemaphore::WinSemaphore(long initial_count, long max_count)
+    : count(static_cast<int>(initial_count)), waiters(0), max_count(max_count) {
+    if (initial_count < 0 || max_count <= 0 || initial_count > max_count) {
+        throw std::runtime_error("CreateSemaphore failed");
+    }
+}
+
+WinSemaphore::~WinSemaphore() {}
+
+void WinSemaphore::wait() {
+    try_wait(INFINITE);
+}
+
+bool WinSemaphore::try_wait(DWORD timeout_ms) {
+    timespec deadline = add_ms(monotonic_now(), timeout_ms);
+    while (true) {
+        int c = count.load(std::memory_order_relaxed);
+        while (c > 0) {
+            if (count.compare_exchange_weak(c, c - 1, std::memory_order_acquire)) return true;
+        }
+        if (timeout_ms == 0) return false;
+
+        const timespec* rel_ptr = NULL;
+        timespec rel;
+        if (timeout_ms != INFINITE) {
+            timespec now = monotonic_now();
+            rel.tv_sec = deadline.tv_sec - now.tv_sec;
+            rel.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (rel.tv_nsec < 0) {
+                rel.tv_sec -= 1;
+                rel.tv_nsec += 1000000000L;
+            }
+            if (rel.tv_sec < 0) return false;
+            rel_ptr = &rel;
+        }
+
+        waiters.fetch_add(1);
+        futex_wait(count, 0, rel_ptr);
+        waiters.fetch_sub(1);
+    }
+}
+
+void WinSemaphore::post() {
+    // 与 ReleaseSemaphore 一致：超过 max_count 的释放被忽略
+    int c = count.load(std::memory_order_relaxed);
+    do {
+        if (c >= max_count) return;
+    } while (!count.compare_exchange_weak(c, c + 1, std::memory_order_release));
+    if (waiters.load() > 0) {
+        futex_wake(count, 1);
+    }
+}
+
+#else
+
+// WinMutex 实现（pthread 递归互斥量，对应 CRITICAL_SECTION 的可重入语义）
+WinMutex::WinMutex() : profile(nullptr), held_profile(nullptr), held_depth(0), hold_since_ns(0) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mtx, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+WinMutex::~WinMutex() {
+    pthread_mutex_destroy(&mtx);
+}
+
+void WinMutex::raw_lock() {
+    pthread_mutex_lock(&mtx);
+}
+
+bool WinMutex::raw_try_lock() {
+    return pthread_mutex_trylock(&mtx) == 0;
+}
+
+void WinMutex::raw_unlock() {
+    pthread_mutex_unlock(&mtx);
+}
+
+// WinSemaphore 实现（互斥量 + 条件变量，支持 max_count 与毫秒级超时）
+WinSemaphore::WinSemaphore(long initial_count, long max_count)
+    : count(initial_count), max_count(max_count) {
+    if (initial_count < 0 || max_count <= 0 || initial_count > max_count) {
+        throw std::runtime_error("CreateSemaphore failed");
+    }
+    pthread_mutex_init(&mtx, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+    pthread_cond_init(&cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+WinSemaphore::~WinSemaphore() {
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mtx);
+}
+
+void WinSemaphore::wait() {
+    try_wait(INFINITE);
+}
+
+bool WinSemaphore::try_wait(DWORD timeout_ms) {
+    pthread_mutex_lock(&mtx);
+    if (count == 0 && timeout_ms != 0) {
+        if (timeout_ms == INFINITE) {
+            while (count == 0) pthread_cond_wait(&cond, &mtx);
+        } else {
+#ifdef __APPLE__
+            timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            timespec deadline = add_ms(now, timeout_ms);
+#else
+            timespec deadline = add_ms(monotonic_now(), timeout_ms);
+#endif
+            while (count == 0) {
+                if (pthread_cond_timedwait(&cond, &mtx, &deadline) == ETIMEDOUT) break;
+            }
+        }
+    }
+    bool acquired = count > 0;
+    if (acquired) --count;
+    pthread_mutex_unlock(&mtx);
+    return acquired;
+}
+
+void WinSemaphore::post() {
+    pthread_mutex_lock(&mtx);
+    if (count < max_count) {
+        ++count;
+        pthread_cond_signal(&cond);
+    }
+    pthread_mutex_unlock(&mtx);
+}
+
+#endif
+
+// WinThread 实现
+WinThread::~WinThread() {
+    // 与 CloseHandle 一致：未 join 的线程被分离，由系统回收
+    if (started) {
+        pthread_detach(handle);
+    }
+}
+
+void WinThread::join() {
+    if (started) {
+        pthread_join(handle, NULL);
+        started = false;
+    }
+}
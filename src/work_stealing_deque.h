@@ -0,0 +1,97 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase–Lev 工作窃取双端队列（Lê 等人的 C11 内存序版本）：
+// 所有者线程在底部 push / pop（LIFO，缓存友好），其他线程在顶部 steal（FIFO），只有争抢最后一个元素时才需要 CAS。
+// 元素为任务编号这类可平凡拷贝的小值。队列满时所有者将数组扩容一倍；旧数组保留到析构，
+// 正在读取旧数组的窃取者因此不会访问已释放的内存（任务数有界，扩容次数为 O(log N)）。
+template<typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t min_capacity = 64) : top(0), bottom(0) {
+        size_t c = 2;
+        while (c < min_capacity) c <<= 1;
+        arrays.push_back(std::make_unique<Array>(c));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // 仅所有者线程调用
+    void push(T value) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > a->mask) a = grow(a, t, b);
+        a->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // 仅所有者线程调用；队列为空时返回 false
+    bool pop(T& out) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // 只剩最后一个元素：与窃取者竞争
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // 任意线程调用；队列为空或与他人竞争失败时返回 false
+    bool steal(T& out) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Array* a = array.load(std::memory_order_acquire);
+        T value = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return false;
+        out = value;
+        return true;
+    }
+
+    // 近似长度（并发下仅作提示）
+    int64_t size_hint() const {
+        return bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Array(size_t capacity)
+            : mask(static_cast<int64_t>(capacity) - 1), items(new std::atomic<T>[capacity]) {}
+        T get(int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) { items[i & mask].store(v, std::memory_order_relaxed); }
+    };
+
+    Array* grow(Array* old, int64_t t, int64_t b) {
+        arrays.push_back(std::make_unique<Array>(static_cast<size_t>(old->mask + 1) * 2));
+        Array* a = arrays.back().get();
+        for (int64_t i = t; i < b; ++i) a->put(i, old->get(i));
+        array.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<Array*> array;
+    std::vector<std::unique_ptr<Array>> arrays;  // 当前与历史数组，只由所有者修改
+};
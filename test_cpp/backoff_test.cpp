@@ -0,0 +1,132 @@
+﻿#include "test_common.h"
+#include "backoff.h"
+#include "simulation.h"
+#include <atomic>
+#include <stdexcept>
+
+// try-lock 路径上的退避策略（backoff.h）：各策略给出的动作与时长范围、参数校验与计数器；
+// 反饥饿的等待计数只计入休眠的轮次
+
+namespace {
+
+void test_configure_validation() {
+    BackoffPolicy policy(4);
+    SIM_CHECK_THROWS(policy.configure(BackoffKind::EXPONENTIAL, 0, 10, 0, 0), std::runtime_error);
+    SIM_CHECK_THROWS(policy.configure(BackoffKind::EXPONENTIAL, 20, 10, 0, 0), std::runtime_error);
+    SIM_CHECK_THROWS(policy.configure(BackoffKind::SPIN_YIELD_SLEEP, 1, 10, -1, 0), std::runtime_error);
+    SIM_CHECK_THROWS(policy.configure(BackoffKind::SPIN_YIELD_SLEEP, 1, 10, 0, -1), std::runtime_error);
+    policy.configure(BackoffKind::EXPONENTIAL, 1, 1, 0, 0);
+}
+
+void test_fixed_is_bounded() {
+    BackoffPolicy policy(4);
+    std::mt19937 gen(1);
+    for (int i = 0; i < 200; ++i) {
+        BackoffStep right = policy.next(BackoffSite::RIGHT_FORK_FAILED, i, 0, gen);
+        SIM_CHECK(right.action == BackoffStep::Action::SLEEP);
+        SIM_CHECK(right.ms >= 50 && right.ms <= 100);
+        // 左叉子被占用时也只等有限时长（释放时会提前唤醒），不会无限期阻塞
+        BackoffStep busy = policy.next(BackoffSite::LEFT_FORK_BUSY, i, 0, gen);
+        SIM_CHECK(busy.action == BackoffStep::Action::SLEEP && busy.ms == 50);
+        BackoffStep denied = policy.next(BackoffSite::LEFT_FORK_DENIED, i, 0, gen);
+        SIM_CHECK(denied.action == BackoffStep::Action::SLEEP && denied.ms == 50);
+    }
+    BackoffStats s = policy.stats();
+    SIM_CHECK(s.sleeps == 600);
+    SIM_CHECK(s.planned_sleep_ms >= 200 * (50 + 50 + 50) && s.planned_sleep_ms <= 200 * (100 + 50 + 50));
+    SIM_CHECK(s.spins == 0 && s.yields == 0);
+}
+
+void test_exponential_growth_and_cap() {
+    BackoffPolicy policy(4);
+    policy.configure(BackoffKind::EXPONENTIAL, 5, 200, 0, 0);
+    std::mt19937 gen(2);
+    for (int attempt = 0; attempt < 12; ++attempt) {
+        long long d = 5;
+        for (int i = 0; i < attempt && d < 200; ++i) d *= 2;
+        if (d > 200) d = 200;
+        for (int i = 0; i < 50; ++i) {
+            BackoffStep step = policy.next(BackoffSite::RIGHT_FORK_FAILED, attempt, 0, gen);
+            SIM_CHECK(step.action == BackoffStep::Action::SLEEP);
+            // equal jitter：落在 [d/2, d]
+            SIM_CHECK(static_cast<long long>(step.ms) >= d / 2 && static_cast<long long>(step.ms) <= d);
+        }
+    }
+}
+
+void test_adaptive_follows_contention() {
+    BackoffPolicy policy(2);
+    policy.configure(BackoffKind::ADAPTIVE, 10, 1000, 0, 0);
+    std::mt19937 gen(3);
+    for (int i = 0; i < 100; ++i) policy.record(0, false);  // 叉子 0 持续争用
+    for (int i = 0; i < 100; ++i) policy.record(1, true);   // 叉子 1 无争用
+    for (int i = 0; i < 50; ++i) {
+        DWORD hot = policy.next(BackoffSite::LEFT_FORK_BUSY, 0, 0, gen).ms;
+        DWORD cold = policy.next(BackoffSite::LEFT_FORK_BUSY, 0, 1, gen).ms;
+        SIM_CHECK(hot >= 700 && hot <= 1250);
+        SIM_CHECK(cold >= 7 && cold <= 13);
+    }
+    // 清零后争用估计回到 0
+    policy.reset_stats();
+    SIM_CHECK(policy.next(BackoffSite::LEFT_FORK_BUSY, 0, 0, gen).ms <= 13);
+}
+
+void test_spin_yield_sleep_stages() {
+    BackoffPolicy policy(1);
+    policy.configure(BackoffKind::SPIN_YIELD_SLEEP, 5, 40, 3, 2);
+    std::mt19937 gen(4);
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        BackoffStep step = policy.next(BackoffSite::RIGHT_FORK_FAILED, attempt, 0, gen);
+        if (attempt < 3) {
+            SIM_CHECK(step.action == BackoffStep::Action::SPIN);
+        } else if (attempt < 5) {
+            SIM_CHECK(step.action == BackoffStep::Action::YIELD);
+        } else {
+            SIM_CHECK(step.action == BackoffStep::Action::SLEEP);
+            SIM_CHECK(step.ms >= 2 && step.ms <= 40);
+        }
+        policy.spin_or_yield(step);
+    }
+    BackoffStats s = policy.stats();
+    SIM_CHECK(s.spins == 3);
+    SIM_CHECK(s.yields == 2);
+    SIM_CHECK(s.sleeps == 3);
+    policy.reset_stats();
+    s = policy.stats();
+    SIM_CHECK(s.spins == 0 && s.yields == 0 && s.sleeps == 0 && s.planned_sleep_ms == 0);
+}
+
+void test_spin_until_reads_word() {
+    BackoffPolicy policy(1);
+    std::atomic<int32_t> holder(-1);
+    policy.spin_until(holder, -1); // 已经空闲：立即返回
+    holder.store(3);
+    policy.spin_until(holder, -1); // 一直被占用：忙等次数用完后返回
+    SIM_CHECK(policy.stats().spins == 2);
+}
+
+void test_spins_do_not_count_as_waits() {
+    // 前 200 次失败都是零时长的自旋：若自旋也计入等待轮数，每个曾等过被占用叉子的哲学家都会超过 200
+    Simulation sim(5, 5);
+    sim.set_backoff_policy(3, 5, 200, 200, 0);
+    SimStats stats = sim.run_virtual(10.0, 11);
+    BackoffStats b = sim.get_backoff_stats();
+    SIM_CHECK(stats.total_meals > 0);
+    SIM_CHECK(b.sleeps > 0);
+    uint64_t waits = 0;
+    for (int w : stats.max_wait_counts) waits += static_cast<uint64_t>(w);
+    SIM_CHECK(waits <= b.sleeps);
+}
+
+} // namespace
+
+int main() {
+    run_test("configure_validation", test_configure_validation);
+    run_test("fixed_is_bounded", test_fixed_is_bounded);
+    run_test("exponential_growth_and_cap", test_exponential_growth_and_cap);
+    run_test("adaptive_follows_contention", test_adaptive_follows_contention);
+    run_test("spin_yield_sleep_stages", test_spin_yield_sleep_stages);
+    run_test("spin_until_reads_word", test_spin_until_reads_word);
+    run_test("spins_do_not_count_as_waits", test_spins_do_not_count_as_waits);
+    return 0;
+}
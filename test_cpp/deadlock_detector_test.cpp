@@ -0,0 +1,137 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 后台死锁检测（simulation.h 的 start_deadlock_detector）：乐观 try-lock 下短暂的等待环能被发现并按
+// CYCLE_MEMBER × 环长 + DETECTION_LATENCY 的格式报告；不会成环的策略不产生误报；参数与启停的边界情况
+
+namespace {
+
+const int STRATEGY_NONE = 0;
+const int STRATEGY_BANKER = 1;
+const int STRATEGY_ORDERED = 2;
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<SimEvent> deadlock_events(const std::vector<SimEvent>& events) {
+    std::vector<SimEvent> out;
+    for (const SimEvent& e : events) {
+        if (e.kind == EventKind::DEADLOCK) out.push_back(e);
+    }
+    return out;
+}
+
+// 检测线程按“环上每位成员一条 CYCLE_MEMBER，随后一条 DETECTION_LATENCY”的顺序发布，且只有它发布这两类事件
+void check_report_format(const std::vector<SimEvent>& reports, int n, int m) {
+    size_t i = 0;
+    while (i < reports.size()) {
+        SIM_CHECK(reports[i].reason == EventReason::CYCLE_MEMBER);
+        int length = reports[i].value;
+        SIM_CHECK(length >= 2 && length <= n);
+        std::vector<bool> seen(n, false);
+        for (int k = 0; k < length; ++k, ++i) {
+            SIM_CHECK(i < reports.size());
+            const SimEvent& member = reports[i];
+            SIM_CHECK(member.reason == EventReason::CYCLE_MEMBER);
+            SIM_CHECK(member.value == length);
+            SIM_CHECK(member.phil_id >= 0 && member.phil_id < n && !seen[member.phil_id]);
+            seen[member.phil_id] = true;
+            // 成员等待的是自己的左叉子或右叉子
+            int left = static_cast<int>((static_cast<long long>(member.phil_id) * m) / n);
+            SIM_CHECK(member.fork_id == left || member.fork_id == (left + 1) % m);
+        }
+        SIM_CHECK(i < reports.size());
+        const SimEvent& latency = reports[i++];
+        SIM_CHECK(latency.reason == EventReason::DETECTION_LATENCY);
+        SIM_CHECK(latency.phil_id >= 0 && latency.phil_id < n && seen[latency.phil_id]);
+        SIM_CHECK(latency.value >= 0 && latency.value < 1000000);
+    }
+}
+
+void test_detects_transient_cycle() {
+    // 16 位哲学家共用 2 把叉子：前一半先拿叉子 0，后一半先拿叉子 1。进餐者放下叉子时会同时唤醒两侧的等待者，
+    // 双方各拿到一把后在两把叉子之间的 10 ms 内互相等待，形成等待环（随后 try-lock 回退将其打破）
+    const int n = 16, m = 2;
+    Simulation sim(n, m);
+    sim.set_event_overflow_policy(1);
+    sim.set_strategy(STRATEGY_NONE);
+    sim.start_deadlock_detector(1);
+    SIM_CHECK(sim.deadlock_detector_running());
+    sim.start();
+
+    std::vector<SimEvent> reports;
+    bool found = false;
+    auto deadline = Clock::now() + std::chrono::seconds(20);
+    while (!found && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (const SimEvent& e : deadlock_events(sim.poll_events())) {
+            reports.push_back(e);
+            if (e.reason == EventReason::DETECTION_LATENCY) found = true;
+        }
+    }
+    sim.stop_deadlock_detector();
+    SIM_CHECK(!sim.deadlock_detector_running());
+    sim.stop();
+    for (const SimEvent& e : deadlock_events(sim.poll_events())) reports.push_back(e);
+
+    SIM_CHECK(found);
+    check_report_format(reports, n, m);
+}
+
+void run_without_cycles(int strategy, int n, int m) {
+    Simulation sim(n, m);
+    sim.set_event_overflow_policy(1);
+    sim.set_strategy(strategy);
+    sim.start_deadlock_detector(1);
+    sim.start();
+    int meals = 0;
+    std::vector<SimEvent> reports;
+    for (int i = 0; i < 10; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        for (const SimEvent& e : sim.poll_events()) {
+            if (e.kind == EventKind::DEADLOCK) reports.push_back(e);
+            if (e.kind == EventKind::STATE && e.reason == EventReason::EATING) meals++;
+        }
+    }
+    SIM_CHECK(!sim.detect_deadlock());
+    sim.stop();
+    sim.stop_deadlock_detector();
+    SIM_CHECK(meals > 0);
+    SIM_CHECK(reports.empty());
+}
+
+void test_no_false_positives() {
+    // 按编号顺序获取与银行家算法都不会形成等待环
+    run_without_cycles(STRATEGY_ORDERED, 4, 2);
+    run_without_cycles(STRATEGY_ORDERED, 5, 5);
+    run_without_cycles(STRATEGY_BANKER, 4, 2);
+    run_without_cycles(STRATEGY_BANKER, 5, 5);
+}
+
+void test_lifecycle() {
+    Simulation sim(5, 5);
+    SIM_CHECK(!sim.detect_deadlock());
+    SIM_CHECK_THROWS(sim.start_deadlock_detector(0), std::runtime_error);
+    SIM_CHECK(!sim.deadlock_detector_running());
+    sim.start_deadlock_detector(5);
+    sim.start_deadlock_detector(5);  // 重复启动无效果
+    SIM_CHECK(sim.deadlock_detector_running());
+    // 仿真未运行时没有饥饿的哲学家，检测线程不报告任何环
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sim.stop_deadlock_detector();
+    sim.stop_deadlock_detector();
+    SIM_CHECK(!sim.deadlock_detector_running());
+    SIM_CHECK(deadlock_events(sim.poll_events()).empty());
+}
+
+} // namespace
+
+int main() {
+    run_test("detects_transient_cycle", test_detects_transient_cycle);
+    run_test("no_false_positives", test_no_false_positives);
+    run_test("lifecycle", test_lifecycle);
+    return 0;
+}
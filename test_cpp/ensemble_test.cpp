@@ -0,0 +1,101 @@
+﻿#include "test_common.h"
+#include "ensemble.h"
+#include <stdexcept>
+#include <vector>
+
+// 集合运行（ensemble.h）：K 个配置得到 K 个互不影响的结果，同一种子结果相同，
+// 只能在线程模式下使用的策略被拒绝，排队中的配置在销毁、清空或其他配置失败时的处理
+
+namespace {
+
+bool same_stats(const SimStats& a, const SimStats& b) {
+    return a.total_meals == b.total_meals && a.events_processed == b.events_processed &&
+           a.eat_counts == b.eat_counts && a.max_wait_counts == b.max_wait_counts;
+}
+
+void test_results_are_independent() {
+    // 配置数多于工作线程，各工作线程会领取多个配置；每个结果都要与单独运行同一配置的结果一致
+    Ensemble ens(3);
+    const int k = 8;
+    for (int i = 0; i < k; ++i) SIM_CHECK(ens.add(3 + i, 2 + i % 4, i % 2, 100 + i, 20.0) == i);
+    SIM_CHECK(ens.size() == k);
+    std::vector<EnsembleResult> results = ens.run();
+    SIM_CHECK(static_cast<int>(results.size()) == k);
+    for (int i = 0; i < k; ++i) {
+        const EnsembleResult& r = results[i];
+        SIM_CHECK(r.config.num_philosophers == 3 + i);
+        SIM_CHECK(r.config.num_forks == 2 + i % 4);
+        SIM_CHECK(r.config.seed == static_cast<unsigned int>(100 + i));
+        SIM_CHECK(static_cast<int>(r.stats.eat_counts.size()) == 3 + i);
+        SIM_CHECK(r.stats.total_meals > 0);
+        SIM_CHECK(r.wall_time >= 0);
+
+        Simulation alone(3 + i, 2 + i % 4);
+        alone.set_strategy(i % 2);
+        SIM_CHECK(same_stats(r.stats, alone.run_virtual(20.0, 100 + i)));
+    }
+}
+
+void test_same_seed_same_result() {
+    Ensemble ens(4);
+    for (int i = 0; i < 4; ++i) ens.add(7, 4, 0, 42, 30.0);
+    ens.add(7, 4, 0, 43, 30.0);
+    std::vector<EnsembleResult> results = ens.run();
+    for (int i = 1; i < 4; ++i) SIM_CHECK(same_stats(results[0].stats, results[i].stats));
+    SIM_CHECK(!same_stats(results[0].stats, results[4].stats));
+
+    // 再次运行同一组配置，结果不变
+    std::vector<EnsembleResult> again = ens.run();
+    for (size_t i = 0; i < results.size(); ++i) SIM_CHECK(same_stats(results[i].stats, again[i].stats));
+}
+
+void test_blocking_strategy_rejected() {
+    // ORDERED、CHANDY_MISRA 与 WAITER 阻塞在叉子或信号量上，只能在线程模式下运行
+    for (int strategy = 2; strategy <= 4; ++strategy) {
+        Ensemble ens(2);
+        ens.add(5, 5, 0, 1, 5.0);
+        ens.add(5, 5, strategy, 1, 5.0);
+        ens.add(5, 5, 1, 1, 5.0);
+        SIM_CHECK_THROWS(ens.run(), std::runtime_error);
+    }
+    Ensemble ens(1);
+    SIM_CHECK_THROWS(ens.add(0, 1), std::runtime_error);
+    SIM_CHECK_THROWS(ens.add(1, 0), std::runtime_error);
+    SIM_CHECK_THROWS(ens.add(2, 2, 0, 0, -1.0), std::runtime_error);
+    SIM_CHECK(ens.size() == 0);
+}
+
+void test_queued_runs() {
+    // 加入但从未运行的配置随 Ensemble 一起销毁，不启动任何工作线程
+    {
+        Ensemble ens(2);
+        for (int i = 0; i < 16; ++i) ens.add(5, 3, 0, i, 1000.0);
+    }
+
+    // 清空后排队的配置不再运行；空的集合直接返回
+    Ensemble ens(2);
+    for (int i = 0; i < 16; ++i) ens.add(5, 3, 0, i, 1000.0);
+    ens.clear();
+    SIM_CHECK(ens.size() == 0);
+    SIM_CHECK(ens.run().empty());
+
+    // 排在失败配置之后的配置照常运行完毕才抛出异常，之后同一个 Ensemble 仍可使用
+    Ensemble failing(1);
+    failing.add(5, 5, 2, 1, 5.0);
+    for (int i = 0; i < 4; ++i) failing.add(5, 3, 0, i, 10.0);
+    SIM_CHECK_THROWS(failing.run(), std::runtime_error);
+    failing.clear();
+    failing.add(5, 3, 0, 9, 10.0);
+    std::vector<EnsembleResult> results = failing.run();
+    SIM_CHECK(results.size() == 1 && results[0].stats.total_meals > 0);
+}
+
+} // namespace
+
+int main() {
+    run_test("results_are_independent", test_results_are_independent);
+    run_test("same_seed_same_result", test_same_seed_same_result);
+    run_test("blocking_strategy_rejected", test_blocking_strategy_rejected);
+    run_test("queued_runs", test_queued_runs);
+    return 0;
+}
@@ -0,0 +1,133 @@
+﻿#include "test_common.h"
+#include "latency_histogram.h"
+#include "simulation.h"
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// HDR 延迟直方图（latency_histogram.h）：线性区间精确、对数区间相对误差不超过 1/32、截断、合并、并发记录，
+// 以及 Simulation::get_latency_percentiles 的汇总与参数检查
+
+namespace {
+
+void test_empty_and_linear_range() {
+    LatencyHistogram h;
+    SIM_CHECK(h.count() == 0);
+    SIM_CHECK(h.max() == 0);
+    SIM_CHECK(h.percentile(0.5) == 0);
+
+    for (uint64_t v = 1; v < 64; ++v) h.record(v);
+    SIM_CHECK(h.count() == 63);
+    SIM_CHECK(h.max() == 63);
+    SIM_CHECK(h.percentile(0.5) == 32);   // [0, 64) 逐个计数，分位数是精确值
+    SIM_CHECK(h.percentile(1.0) == 63);
+    SIM_CHECK(h.percentile(0.01) == 1);
+
+    h.reset();
+    SIM_CHECK(h.count() == 0 && h.max() == 0);
+}
+
+void test_relative_error_bound() {
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t v = 64 + rng() % (0xFFFFFFFFull - 64);
+        LatencyHistogram h;
+        h.record(v);
+        h.record(0xFFFFFFFFull);            // 让最大值不截断 v 所在桶的上界
+        uint64_t p = h.percentile(0.5);
+        SIM_CHECK(p >= v);
+        SIM_CHECK(p - v <= v / 32);
+    }
+    // 桶边界两侧：2 的幂本身落在新区间的第一个桶
+    for (int bit = 6; bit < 32; ++bit) {
+        uint64_t v = 1ull << bit;
+        LatencyHistogram h;
+        h.record(v - 1);
+        h.record(v);
+        h.record(0xFFFFFFFFull);
+        SIM_CHECK(h.percentile(1.0 / 3) < v);
+        SIM_CHECK(h.percentile(2.0 / 3) >= v);
+    }
+}
+
+void test_clamp_to_max_value() {
+    LatencyHistogram h;
+    h.record(1ull << 40);
+    SIM_CHECK(h.count() == 1);
+    SIM_CHECK(h.max() == 0xFFFFFFFFull);
+    SIM_CHECK(h.percentile(1.0) == 0xFFFFFFFFull);
+}
+
+void test_merge() {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    for (int i = 0; i < 90; ++i) a.record(10);
+    for (int i = 0; i < 10; ++i) b.record(5000);
+    LatencyHistogram all;
+    all.merge(a);
+    all.merge(b);
+    SIM_CHECK(all.count() == 100);
+    SIM_CHECK(all.max() == 5000);
+    SIM_CHECK(all.percentile(0.5) == 10);
+    SIM_CHECK(all.percentile(0.95) == 5000);
+    SIM_CHECK(a.count() == 90 && b.count() == 10);  // 合并不改动来源
+}
+
+void test_concurrent_record() {
+    const int threads = 4;
+    const int per_thread = 100000;
+    LatencyHistogram h;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&h, t] {
+            for (int i = 0; i < per_thread; ++i) h.record(static_cast<uint64_t>(i % 1000 + t));
+        });
+    }
+    for (auto& w : workers) w.join();
+    SIM_CHECK(h.count() == static_cast<uint64_t>(threads) * per_thread);
+    SIM_CHECK(h.max() == 999 + threads - 1);
+}
+
+void test_simulation_percentiles() {
+    Simulation sim(5, 5);
+    sim.set_latency_tracking(true);
+    SimStats stats = sim.run_virtual(60.0, 11);
+    SIM_CHECK(stats.total_meals > 0);
+
+    // 思考与进餐时长取自 [500, 1000] 毫秒，分位数至多偏大 1/32
+    const int metrics[] = {static_cast<int>(LatencyMetric::THINK), static_cast<int>(LatencyMetric::EAT)};
+    for (int metric : metrics) {
+        LatencyPercentiles all = sim.get_latency_percentiles(metric);
+        SIM_CHECK(all.count > 0);
+        SIM_CHECK(all.p50 >= 500.0 && all.p50 <= 1000.0 * 33 / 32);
+        SIM_CHECK(all.p50 <= all.p99 && all.p99 <= all.p999 && all.p999 <= all.max);
+        SIM_CHECK(all.max <= 1000.0);
+    }
+    LatencyPercentiles eat = sim.get_latency_percentiles(static_cast<int>(LatencyMetric::EAT));
+    // 进餐结束时才记录时长，运行截止时正在进餐的（至多每人一次）尚未计入
+    SIM_CHECK(eat.count <= static_cast<uint64_t>(stats.total_meals));
+    SIM_CHECK(eat.count + 5 >= static_cast<uint64_t>(stats.total_meals));
+
+    // 按哲学家查询的计数之和等于合并后的计数
+    uint64_t sum = 0;
+    for (int i = 0; i < 5; ++i) sum += sim.get_latency_percentiles(static_cast<int>(LatencyMetric::WAIT), i).count;
+    SIM_CHECK(sum == sim.get_latency_percentiles(static_cast<int>(LatencyMetric::WAIT)).count);
+
+    SIM_CHECK_THROWS(sim.get_latency_percentiles(4), std::runtime_error);
+    SIM_CHECK_THROWS(sim.get_latency_percentiles(0, 5), std::runtime_error);
+    SIM_CHECK_THROWS(sim.get_latency_percentiles(0, -2), std::runtime_error);
+}
+
+} // namespace
+
+int main() {
+    run_test("empty_and_linear_range", test_empty_and_linear_range);
+    run_test("relative_error_bound", test_relative_error_bound);
+    run_test("clamp_to_max_value", test_clamp_to_max_value);
+    run_test("merge", test_merge);
+    run_test("concurrent_record", test_concurrent_record);
+    run_test("simulation_percentiles", test_simulation_percentiles);
+    return 0;
+}
@@ -0,0 +1,115 @@
+﻿#include "test_common.h"
+#include "lock_profile.h"
+#include "simulation.h"
+#include "win_sync.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// 锁争用剖析（lock_profile.h）：WinMutex 的获取 / 争用 / try_lock 失败计数、等待与持有时长，
+// 以及与时间线追踪同时启用时每次加锁仍只计一次获取
+
+namespace {
+
+const uint64_t MS = 1000000;
+
+void test_counts_outermost_acquisitions() {
+    WinMutex m;
+    LockProfile p;
+    m.set_profile(&p);
+    m.lock();
+    m.lock();  // 重入不重复计数
+    SIM_CHECK(m.try_lock());
+    m.unlock();
+    m.unlock();
+    m.unlock();
+    SIM_CHECK(p.acquisitions.load() == 1);
+    SIM_CHECK(m.try_lock());
+    m.unlock();
+    SIM_CHECK(p.acquisitions.load() == 2);
+    SIM_CHECK(p.contended.load() == 0);
+    SIM_CHECK(p.failed_try_locks.load() == 0);
+    SIM_CHECK(p.wait_ns.load() == 0);
+
+    m.set_profile(nullptr);
+    m.lock();
+    m.unlock();
+    SIM_CHECK(p.acquisitions.load() == 2);
+}
+
+void test_contended_lock_and_failed_try() {
+    WinMutex m;
+    LockProfile p;
+    m.set_profile(&p);
+    std::atomic<bool> held(false);
+    std::thread holder([&] {
+        m.lock();
+        held = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        m.unlock();
+    });
+    while (!held) std::this_thread::yield();
+    SIM_CHECK(!m.try_lock());
+    SIM_CHECK(p.failed_try_locks.load() == 1);
+
+    // 同一次获取中测量等待：计一次获取、一次争用，不额外产生 try_lock 失败
+    uint64_t waited = m.lock_and_measure();
+    m.unlock();
+    holder.join();
+    SIM_CHECK(waited >= 30 * MS);
+    SIM_CHECK(p.acquisitions.load() == 2);
+    SIM_CHECK(p.contended.load() == 1);
+    SIM_CHECK(p.failed_try_locks.load() == 1);
+    SIM_CHECK(p.wait_ns.load() == waited);
+    SIM_CHECK(p.hold_ns.load() >= 30 * MS);
+
+    // 未争用时不读时钟，返回 0
+    SIM_CHECK(m.lock_and_measure() == 0);
+    m.unlock();
+    SIM_CHECK(p.acquisitions.load() == 3);
+}
+
+void test_measure_without_profile() {
+    WinMutex m;
+    SIM_CHECK(m.lock_and_measure() == 0);
+    m.unlock();
+}
+
+void test_profiling_with_trace() {
+    // ORDERED 只以阻塞方式锁叉子与 state_mutex，从不 try_lock：同时启用追踪时也不应出现 try_lock 失败
+    const char* path = "lock_profile_test_trace.json";
+    Simulation sim(8, 3);
+    sim.set_strategy(2);
+    sim.set_lock_profiling(true);
+    sim.set_trace_output(path);
+    sim.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    sim.stop();
+
+    bool saw_forks = false;
+    for (const LockStats& s : sim.get_lock_stats()) {
+        if (s.name == "state_mutex" || s.name == "forks") {
+            SIM_CHECK(s.failed_try_locks == 0);
+            SIM_CHECK(s.contended <= s.acquisitions);
+        }
+        if (s.name == "forks") {
+            saw_forks = true;
+            SIM_CHECK(s.acquisitions > 0);
+            SIM_CHECK(s.contended > 0);  // 8 人共享 3 把叉子
+            SIM_CHECK(s.wait_ms > 0);
+        }
+    }
+    SIM_CHECK(saw_forks);
+    std::remove(path);
+}
+
+} // namespace
+
+int main() {
+    run_test("counts_outermost_acquisitions", test_counts_outermost_acquisitions);
+    run_test("contended_lock_and_failed_try", test_contended_lock_and_failed_try);
+    run_test("measure_without_profile", test_measure_without_profile);
+    run_test("profiling_with_trace", test_profiling_with_trace);
+    return 0;
+}
@@ -0,0 +1,112 @@
+﻿#include "test_common.h"
+#include "mpsc_ring.h"
+#include "simulation.h"
+#include <thread>
+#include <vector>
+
+// 事件日志：有界无锁 MPSC 环形队列（mpsc_ring.h）与 Simulation 的溢出策略
+
+namespace {
+
+struct Item {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+void test_fifo_and_bounds() {
+    MpscRing<int> ring(5);
+    SIM_CHECK(ring.capacity() == 8);  // 向上取整为 2 的幂
+    int out = 0;
+    SIM_CHECK(!ring.try_pop(out));
+    for (int i = 0; i < 8; ++i) SIM_CHECK(ring.try_push(i));
+    SIM_CHECK(!ring.try_push(8));
+    for (int i = 0; i < 8; ++i) {
+        SIM_CHECK(ring.try_pop(out));
+        SIM_CHECK(out == i);
+    }
+    SIM_CHECK(!ring.try_pop(out));
+    SIM_CHECK(ring.pushed() == 8);
+}
+
+void test_overflow_counters() {
+    MpscRing<int> drop(4);
+    for (int i = 0; i < 10; ++i) drop.push_or_drop(i);
+    SIM_CHECK(drop.pushed() == 4);
+    SIM_CHECK(drop.dropped() == 6);
+    int out = 0;
+    SIM_CHECK(drop.try_pop(out) && out == 0);  // 丢弃的是新记录
+
+    MpscRing<int> overwrite(4);
+    for (int i = 0; i < 10; ++i) overwrite.push_overwrite(i);
+    SIM_CHECK(overwrite.overwritten() == 6);
+    for (int i = 6; i < 10; ++i) {
+        SIM_CHECK(overwrite.try_pop(out));
+        SIM_CHECK(out == i);  // 保留最近的 capacity 条
+    }
+    SIM_CHECK(!overwrite.try_pop(out));
+}
+
+void test_concurrent_producers() {
+    // 多个生产者与一个消费者并发：每条记录恰好取出一次，且同一生产者的记录保持入队顺序
+    const int producers = 4;
+    const uint32_t per_producer = 50000;
+    MpscRing<Item> ring(256);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (uint32_t s = 0; s < per_producer; ++s) {
+                while (!ring.try_push(Item{static_cast<uint32_t>(p), s})) std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<uint32_t> next(producers, 0);
+    uint64_t received = 0;
+    Item item{};
+    while (received < producers * static_cast<uint64_t>(per_producer)) {
+        if (!ring.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        SIM_CHECK(item.producer < static_cast<uint32_t>(producers));
+        SIM_CHECK(item.seq == next[item.producer]);
+        next[item.producer]++;
+        received++;
+    }
+    for (auto& t : threads) t.join();
+    SIM_CHECK(!ring.try_pop(item));
+    SIM_CHECK(ring.dropped() == 0);
+}
+
+void test_simulation_overflow_policy() {
+    // 60 秒虚拟时间的 50 位哲学家产生的事件远多于队列容量
+    Simulation overwrite(50, 50);
+    overwrite.run_virtual(60.0, 1);
+    EventLogStats s = overwrite.get_event_log_stats();
+    SIM_CHECK(s.overwritten > 0);
+    SIM_CHECK(s.dropped == 0);
+    std::vector<SimEvent> events = overwrite.poll_events();
+    SIM_CHECK(events.size() == s.capacity);
+    // 默认覆盖最旧记录：最后一条是 VIRTUAL_STOPPED
+    SIM_CHECK(events.back().kind == EventKind::SYSTEM && events.back().reason == EventReason::VIRTUAL_STOPPED);
+
+    Simulation drop(50, 50);
+    drop.set_event_overflow_policy(1);
+    drop.run_virtual(60.0, 1);
+    s = drop.get_event_log_stats();
+    SIM_CHECK(s.dropped > 0);
+    SIM_CHECK(s.overwritten == 0);
+    events = drop.poll_events();
+    SIM_CHECK(events.size() == s.capacity);
+    SIM_CHECK(events.front().kind == EventKind::SYSTEM && events.front().reason == EventReason::VIRTUAL_STARTED);
+    SIM_CHECK(drop.poll_events().empty());
+}
+
+} // namespace
+
+int main() {
+    run_test("fifo_and_bounds", test_fifo_and_bounds);
+    run_test("overflow_counters", test_overflow_counters);
+    run_test("concurrent_producers", test_concurrent_producers);
+    run_test("simulation_overflow_policy", test_simulation_overflow_policy);
+    return 0;
+}
@@ -0,0 +1,177 @@
+﻿#include "test_common.h"
+#include "safety_bitset.h"
+#include <random>
+#include <vector>
+
+// 位并行安全性检查内核（safety_bitset.h）：64 位与 AVX2 两个内核都与逐哲学家的银行家不动点循环核对，
+// 覆盖 N != M 的比例映射、安全与不安全状态、跨 64 位字边界的叉子数以及增量的 set_holder
+
+namespace {
+
+struct Table {
+    int num_phil;
+    int num_forks;
+    std::vector<int> left_fork_of;
+    std::vector<int> right_fork_of;
+    std::vector<int> holder;
+};
+
+// 与 Simulation 相同的比例映射
+Table make_table(int n, int m) {
+    Table t;
+    t.num_phil = n;
+    t.num_forks = m;
+    t.left_fork_of.resize(n);
+    t.right_fork_of.resize(n);
+    for (int i = 0; i < n; ++i) {
+        t.left_fork_of[i] = static_cast<int>((static_cast<long long>(i) * m) / n);
+        t.right_fork_of[i] = (t.left_fork_of[i] + 1) % m;
+    }
+    t.holder.assign(m, -1);
+    return t;
+}
+
+// 参考实现：反复扫描所有哲学家，能拿齐叉子的视为完成并归还其叉子
+bool reference_safe(const Table& t) {
+    std::vector<char> available(t.num_forks), finished(t.num_phil, 0);
+    for (int f = 0; f < t.num_forks; ++f) available[f] = (t.holder[f] == -1);
+    int remaining = t.num_phil;
+    bool progress = true;
+    while (progress && remaining > 0) {
+        progress = false;
+        for (int i = 0; i < t.num_phil; ++i) {
+            if (finished[i]) continue;
+            int l = t.left_fork_of[i];
+            int r = t.right_fork_of[i];
+            if ((available[l] || t.holder[l] == i) && (available[r] || t.holder[r] == i)) {
+                if (t.holder[l] == i) available[l] = 1;
+                if (t.holder[r] == i) available[r] = 1;
+                finished[i] = 1;
+                --remaining;
+                progress = true;
+            }
+        }
+    }
+    return remaining == 0;
+}
+
+std::vector<BitsetSafetyChecker::Kernel> kernels() {
+    std::vector<BitsetSafetyChecker::Kernel> result{BitsetSafetyChecker::Kernel::SCALAR};
+    if (BitsetSafetyChecker::avx2_available()) result.push_back(BitsetSafetyChecker::Kernel::AVX2);
+    return result;
+}
+
+BitsetSafetyChecker make_checker(const Table& t, BitsetSafetyChecker::Kernel kernel) {
+    BitsetSafetyChecker checker(t.left_fork_of, t.right_fork_of, t.num_forks);
+    checker.set_kernel(kernel);
+    for (int f = 0; f < t.num_forks; ++f) {
+        if (t.holder[f] != -1) checker.set_holder(f, t.holder[f]);
+    }
+    return checker;
+}
+
+void test_full_cycle_is_unsafe() {
+    for (auto kernel : kernels()) {
+        for (int n : {2, 5, 64, 65, 200}) {
+            Table t = make_table(n, n);
+            for (int i = 0; i < n; ++i) t.holder[t.left_fork_of[i]] = i;  // 每人拿着左叉子：成环
+            SIM_CHECK(!reference_safe(t));
+            BitsetSafetyChecker checker = make_checker(t, kernel);
+            SIM_CHECK(!checker.is_safe());
+
+            // 任意一位放下叉子后成为一条链，变为安全
+            checker.set_holder(t.left_fork_of[n / 2], -1);
+            t.holder[t.left_fork_of[n / 2]] = -1;
+            SIM_CHECK(reference_safe(t));
+            SIM_CHECK(checker.is_safe());
+            // 再分回去必须被拒绝
+            SIM_CHECK(!checker.is_safe_after_grant(n / 2, t.left_fork_of[n / 2]));
+        }
+    }
+}
+
+void test_cycle_with_fewer_forks_is_unsafe() {
+    // N > M：每把叉子都被以它为左叉子的一位哲学家拿着，同样成环
+    for (auto kernel : kernels()) {
+        Table t = make_table(30, 20);
+        for (int i = 0; i < t.num_phil; ++i) {
+            if (t.holder[t.left_fork_of[i]] == -1) t.holder[t.left_fork_of[i]] = i;
+        }
+        SIM_CHECK(!reference_safe(t));
+        SIM_CHECK(!make_checker(t, kernel).is_safe());
+    }
+}
+
+void test_random_states_match_reference() {
+    // 不经安全检查随机分配叉子：密度由低到高，安全与不安全的状态都会大量出现
+    const int shapes[][2] = {{2, 2}, {3, 2}, {5, 5}, {5, 3}, {5, 8}, {7, 11}, {63, 64}, {64, 64},
+                             {65, 64}, {64, 65}, {100, 129}, {129, 100}, {300, 128}, {128, 300}};
+    std::mt19937 rng(2024);
+    int safe_seen = 0, unsafe_seen = 0;
+    for (auto kernel : kernels()) {
+        for (const auto& shape : shapes) {
+            for (int trial = 0; trial < 40; ++trial) {
+                Table t = make_table(shape[0], shape[1]);
+                int grabs = static_cast<int>(rng() % (3 * t.num_phil + 1));
+                for (int k = 0; k < grabs; ++k) {
+                    int i = static_cast<int>(rng() % t.num_phil);
+                    int f = (rng() & 1) ? t.left_fork_of[i] : t.right_fork_of[i];
+                    if (t.holder[f] == -1) t.holder[f] = i;
+                }
+                bool expected = reference_safe(t);
+                (expected ? safe_seen : unsafe_seen)++;
+                SIM_CHECK(make_checker(t, kernel).is_safe() == expected);
+            }
+        }
+    }
+    SIM_CHECK(safe_seen > 0);
+    SIM_CHECK(unsafe_seen > 0);
+}
+
+void test_incremental_updates_match_reference() {
+    // 随机的获取与释放序列：每一步都核对当前状态与所有可能的下一次分配
+    const int shapes[][2] = {{5, 5}, {9, 6}, {6, 9}, {70, 66}, {66, 70}};
+    std::mt19937 rng(7);
+    for (auto kernel : kernels()) {
+        for (const auto& shape : shapes) {
+            Table t = make_table(shape[0], shape[1]);
+            BitsetSafetyChecker checker = make_checker(t, kernel);
+            for (int step = 0; step < 300; ++step) {
+                int i = static_cast<int>(rng() % t.num_phil);
+                int f = (rng() & 1) ? t.left_fork_of[i] : t.right_fork_of[i];
+                if (t.holder[f] == -1) {
+                    t.holder[f] = i;
+                    checker.set_holder(f, i);
+                } else if (t.holder[f] == i || (rng() & 1)) {
+                    t.holder[f] = -1;
+                    checker.set_holder(f, -1);
+                }
+                SIM_CHECK(checker.is_safe() == reference_safe(t));
+
+                for (int p = 0; p < t.num_phil; ++p) {
+                    for (int g : {t.left_fork_of[p], t.right_fork_of[p]}) {
+                        bool expected = false;
+                        if (t.holder[g] == -1) {
+                            t.holder[g] = p;
+                            expected = reference_safe(t);
+                            t.holder[g] = -1;
+                        }
+                        SIM_CHECK(checker.is_safe_after_grant(p, g) == expected);
+                    }
+                }
+            }
+            checker.reset();
+            SIM_CHECK(checker.is_safe());
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    run_test("full_cycle_is_unsafe", test_full_cycle_is_unsafe);
+    run_test("cycle_with_fewer_forks_is_unsafe", test_cycle_with_fewer_forks_is_unsafe);
+    run_test("random_states_match_reference", test_random_states_match_reference);
+    run_test("incremental_updates_match_reference", test_incremental_updates_match_reference);
+    return 0;
+}
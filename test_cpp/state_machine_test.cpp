@@ -0,0 +1,195 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 哲学家状态机（step_philosopher 与协程版共用的状态转换）：虚拟时间、任务与协程三种模式下，
+// 每位哲学家的事件序列都必须符合 THINKING -> HUNGRY -> 左叉子 -> 右叉子 -> EATING -> 释放 的顺序；
+// 同一配置下虚拟时间模式的进餐速率、退避与重试比例要与线程模式、任务模式相当（虚拟运行才能预测线程模式）
+
+namespace {
+
+struct PhilosopherTrace {
+    int state = -1;  // 最近一次 STATE 事件，-1 表示尚未开始
+    bool left = false;
+    bool right = false;
+    int meals = 0;
+};
+
+// 逐条核对事件序列，返回进餐总次数
+int check_event_order(Simulation& sim, int n) {
+    std::vector<PhilosopherTrace> phils(n);
+    for (const SimEvent& e : sim.poll_events()) {
+        if (e.phil_id < 0 || (e.kind != EventKind::STATE && e.kind != EventKind::ACQUIRE &&
+                              e.kind != EventKind::RELEASE)) {
+            continue;
+        }
+        PhilosopherTrace& p = phils[e.phil_id];
+        const int thinking = static_cast<int>(State::THINKING);
+        const int hungry = static_cast<int>(State::HUNGRY);
+        const int eating = static_cast<int>(State::EATING);
+        switch (e.reason) {
+        case EventReason::THINKING:
+            SIM_CHECK(p.state == -1 || p.state == eating);
+            SIM_CHECK(!p.left && !p.right);
+            p.state = thinking;
+            break;
+        case EventReason::HUNGRY:
+            SIM_CHECK(p.state == thinking);
+            p.state = hungry;
+            break;
+        case EventReason::EATING:
+            SIM_CHECK(p.state == hungry && p.left && p.right);
+            p.state = eating;
+            p.meals++;
+            break;
+        case EventReason::LEFT_FORK:
+            SIM_CHECK(!p.right);
+            if (e.kind == EventKind::ACQUIRE) {
+                SIM_CHECK(p.state == hungry && !p.left);
+            } else {
+                SIM_CHECK(p.state == eating && p.left);
+            }
+            p.left = (e.kind == EventKind::ACQUIRE);
+            break;
+        case EventReason::RIGHT_FORK:
+            if (e.kind == EventKind::ACQUIRE) {
+                SIM_CHECK(p.state == hungry && p.left && !p.right);
+            } else {
+                SIM_CHECK(p.state == eating && p.right);
+            }
+            p.right = (e.kind == EventKind::ACQUIRE);
+            break;
+        case EventReason::LEFT_FORK_BACKOFF:
+        case EventReason::LEFT_FORK_DENIED:
+            SIM_CHECK(e.kind == EventKind::RELEASE);
+            SIM_CHECK(p.state == hungry && p.left && !p.right);
+            p.left = false;
+            break;
+        default:
+            SIM_CHECK(false);
+        }
+    }
+    int meals = 0;
+    for (const PhilosopherTrace& p : phils) meals += p.meals;
+    return meals;
+}
+
+void test_virtual_mode() {
+    const int n = 9;
+    Simulation sim(n, 6);
+    sim.set_event_overflow_policy(1);  // 保留开头的事件，序列才完整
+    SimStats stats = sim.run_virtual(20.0, 3);
+    SIM_CHECK(stats.total_meals > 0);
+    SIM_CHECK(check_event_order(sim, n) == stats.total_meals);
+}
+
+// 线程化的运行模式：运行一段时间后停止，核对事件序列并确认叉子全部归还
+void run_threaded_mode(Simulation& sim, int n) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    sim.stop();
+    SIM_CHECK(check_event_order(sim, n) > 0);
+    SimSnapshot snap = sim.get_snapshot();
+    for (int holder : snap.fork_holders) SIM_CHECK(holder == -1);
+}
+
+void test_task_mode() {
+    const int n = 8;
+    Simulation sim(n, 8);
+    sim.set_event_overflow_policy(1);
+    sim.start_tasks(2);
+    run_threaded_mode(sim, n);
+}
+
+void test_coroutine_mode() {
+    const int n = 8;
+    Simulation sim(n, 8);
+    sim.set_event_overflow_policy(1);
+    try {
+        sim.start_coroutines(2);
+    } catch (const std::runtime_error&) {
+        // 未以 SIM_ENABLE_COROUTINES 构建：按文档抛出异常，且没有启动任何东西
+        std::printf("coroutines not built in, checked the error path only\n");
+        SIM_CHECK(sim.poll_events().empty());
+        return;
+    }
+    run_threaded_mode(sim, n);
+}
+
+// 一次运行的比例：每位哲学家每秒的进餐次数，每餐的右叉子退避次数（LEFT_FORK_BACKOFF）与退避总次数
+struct ModeRates {
+    double meals_per_phil_sec;
+    double backoffs_per_meal;
+    double retries_per_meal;
+};
+
+ModeRates rates_of(Simulation& sim, int n, double seconds, int meals, int backoffs) {
+    SIM_CHECK(meals > 0);
+    BackoffStats b = sim.get_backoff_stats();
+    return {meals / (n * seconds), static_cast<double>(backoffs) / meals,
+            static_cast<double>(b.spins + b.yields + b.sleeps) / meals};
+}
+
+void count_events(const std::vector<SimEvent>& events, int& meals, int& backoffs) {
+    for (const SimEvent& e : events) {
+        if (e.kind == EventKind::STATE && e.reason == EventReason::EATING) meals++;
+        if (e.kind == EventKind::RELEASE && e.reason == EventReason::LEFT_FORK_BACKOFF) backoffs++;
+    }
+}
+
+// start 启动线程化的模式，运行 seconds 秒（按墙钟）后停止
+template<typename Start>
+ModeRates run_real_time(int n, int m, double seconds, Start start) {
+    Simulation sim(n, m);
+    sim.set_event_overflow_policy(1);
+    int meals = 0, backoffs = 0;
+    auto begin = std::chrono::steady_clock::now();
+    start(sim);
+    while (std::chrono::steady_clock::now() - begin < std::chrono::duration<double>(seconds)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        count_events(sim.poll_events(), meals, backoffs);
+    }
+    sim.stop();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    count_events(sim.poll_events(), meals, backoffs);
+    return rates_of(sim, n, elapsed, meals, backoffs);
+}
+
+void check_close(double expected, double actual, double factor) {
+    std::printf("  expected %.3f, got %.3f\n", expected, actual);
+    SIM_CHECK(actual >= expected / factor && actual <= expected * factor);
+}
+
+void test_modes_agree() {
+    // 7:4 的比例下叉子争用激烈，右叉子失败与退避频繁发生；线程与任务模式不可设种子，
+    // 只能按比例比较，容差覆盖几秒钟运行的随机波动
+    const int n = 21, m = 12;
+    Simulation virt(n, m);
+    virt.set_event_overflow_policy(1);
+    SimStats stats = virt.run_virtual(120.0, 7);
+    int meals = 0, backoffs = 0;
+    count_events(virt.poll_events(), meals, backoffs);
+    SIM_CHECK(meals == stats.total_meals);
+    ModeRates expected = rates_of(virt, n, 120.0, meals, backoffs);
+
+    ModeRates threaded = run_real_time(n, m, 5.0, [](Simulation& sim) { sim.start(); });
+    ModeRates tasks = run_real_time(n, m, 5.0, [](Simulation& sim) { sim.start_tasks(2); });
+    for (const ModeRates& actual : {threaded, tasks}) {
+        check_close(expected.meals_per_phil_sec, actual.meals_per_phil_sec, 1.35);
+        check_close(expected.backoffs_per_meal, actual.backoffs_per_meal, 2.0);
+        check_close(expected.retries_per_meal, actual.retries_per_meal, 2.0);
+    }
+}
+
+} // namespace
+
+int main() {
+    run_test("virtual_mode", test_virtual_mode);
+    run_test("task_mode", test_task_mode);
+    run_test("coroutine_mode", test_coroutine_mode);
+    run_test("modes_agree", test_modes_agree);
+    return 0;
+}
@@ -0,0 +1,138 @@
+﻿#include "test_common.h"
+#include "state_snapshot.h"
+#include "simulation.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 状态快照（state_snapshot.h）：单线程的读写与版本号，以及并发写入下读到的必须是一致切面
+
+namespace {
+
+struct Slots {
+    std::vector<std::unique_ptr<SnapshotSlot>> states;
+    std::vector<std::unique_ptr<SnapshotSlot>> holders;
+
+    Slots(int n, int m) {
+        for (int i = 0; i < n; ++i) states.push_back(std::make_unique<SnapshotSlot>(0));
+        for (int f = 0; f < m; ++f) holders.push_back(std::make_unique<SnapshotSlot>(-1));
+    }
+
+    uint64_t read(const StateSnapshot& snap, std::vector<int>& s, std::vector<int>& h) const {
+        return snap.read(static_cast<int>(states.size()), [this](int i) -> const SnapshotSlot& { return *states[i]; },
+                         static_cast<int>(holders.size()), [this](int f) -> const SnapshotSlot& { return *holders[f]; },
+                         s, h);
+    }
+};
+
+void test_publish_and_read() {
+    StateSnapshot snap;
+    Slots slots(3, 2);
+    std::vector<int> s, h;
+    SIM_CHECK(slots.read(snap, s, h) == 0);
+    SIM_CHECK((s == std::vector<int>{0, 0, 0}));
+    SIM_CHECK((h == std::vector<int>{-1, -1}));
+
+    snap.publish(*slots.states[1], 2);
+    snap.publish(*slots.holders[0], 1);
+    snap.publish(*slots.holders[0], -1);
+    SIM_CHECK(slots.read(snap, s, h) == 3);
+    SIM_CHECK((s == std::vector<int>{0, 2, 0}));
+    SIM_CHECK((h == std::vector<int>{-1, -1}));
+
+    // 两次读取之间的写入都可见，版本号只增不减
+    snap.publish(*slots.states[2], 1);
+    SIM_CHECK(slots.read(snap, s, h) == 4);
+    SIM_CHECK(s[2] == 1);
+}
+
+void test_consistent_cut_under_writers() {
+    // 环形流水线：线程 j 只写第 j 段槽位（按编号顺序），等线程 j-1 写完第 k 轮后才写第 k 轮
+    // （线程 0 等最后一个线程写完第 k-1 轮）。任意一致切面上槽位值沿编号不增，且首尾至多差 1；
+    // 版本号等于各槽位值之和。逐个复制当前值的朴素读取会看到后面的槽位比前面的新，违反这一条件。
+    // 槽位足够多，使一次读取跨越多次写入（单核机器上也会在读取中途被抢占）
+    const int writers = 4;
+    const int per_writer = 16384;
+    const int n = writers * per_writer;
+    StateSnapshot snap;
+    Slots slots(n, 0);
+    std::atomic<bool> stop(false);
+    std::unique_ptr<std::atomic<int>[]> done(new std::atomic<int>[writers]);
+    for (int j = 0; j < writers; ++j) done[j].store(0);
+
+    std::vector<std::thread> threads;
+    for (int j = 0; j < writers; ++j) {
+        threads.emplace_back([&, j] {
+            int prev = (j == 0) ? writers - 1 : j - 1;
+            for (int k = 1; !stop.load(std::memory_order_relaxed); ++k) {
+                int needed = (j == 0) ? k - 1 : k;
+                while (done[prev].load(std::memory_order_acquire) < needed) {
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    std::this_thread::yield();
+                }
+                for (int i = j * per_writer; i < (j + 1) * per_writer; ++i) snap.publish(*slots.states[i], k);
+                done[j].store(k, std::memory_order_release);
+            }
+        });
+    }
+
+    std::vector<int> s, h;
+    uint64_t last_version = 0;
+    int reads = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1500);
+    while (std::chrono::steady_clock::now() < deadline) {
+        uint64_t version = slots.read(snap, s, h);
+        uint64_t sum = 0;
+        for (int i = 0; i < n; ++i) {
+            sum += s[i];
+            if (i > 0) SIM_CHECK(s[i] <= s[i - 1]);
+        }
+        SIM_CHECK(s[0] <= s[n - 1] + 1);
+        SIM_CHECK(version == sum);
+        SIM_CHECK(version >= last_version);
+        last_version = version;
+        reads++;
+    }
+    stop.store(true);
+    for (auto& t : threads) t.join();
+    SIM_CHECK(reads > 0);
+    SIM_CHECK(done[writers - 1].load() > 0);
+}
+
+void test_simulation_snapshot() {
+    // 线程模式运行中反复读取：每把叉子的持有者是 -1 或确实需要这把叉子的哲学家
+    const int n = 7, m = 5;
+    Simulation sim(n, m);
+    sim.start();
+    uint64_t last_version = 0;
+    for (int r = 0; r < 40; ++r) {
+        SimSnapshot snap = sim.get_snapshot();
+        SIM_CHECK(static_cast<int>(snap.states.size()) == n);
+        SIM_CHECK(static_cast<int>(snap.fork_holders.size()) == m);
+        SIM_CHECK(snap.version >= last_version);
+        last_version = snap.version;
+        for (int f = 0; f < m; ++f) {
+            int h = snap.fork_holders[f];
+            if (h == -1) continue;
+            SIM_CHECK(h >= 0 && h < n);
+            int left = static_cast<int>((static_cast<long long>(h) * m) / n);
+            SIM_CHECK(f == left || f == (left + 1) % m);
+        }
+        Sleep(25);
+    }
+    sim.stop();
+    SimSnapshot final_snap = sim.get_snapshot();
+    SIM_CHECK(final_snap.states == sim.get_states());
+    for (int h : final_snap.fork_holders) SIM_CHECK(h == -1);
+}
+
+} // namespace
+
+int main() {
+    run_test("publish_and_read", test_publish_and_read);
+    run_test("consistent_cut_under_writers", test_consistent_cut_under_writers);
+    run_test("simulation_snapshot", test_simulation_snapshot);
+    return 0;
+}
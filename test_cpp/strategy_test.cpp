@@ -0,0 +1,143 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 资源分配策略（strategy.h）：五种策略在线程模式下都能持续进餐、不死锁并归还全部叉子；
+// 阻塞式策略拒绝虚拟时间与任务模式；Chandy–Misra 在切换走再切换回来之后仍能继续进餐
+
+namespace {
+
+const int STRATEGY_NONE = 0;
+const int STRATEGY_BANKER = 1;
+const int STRATEGY_ORDERED = 2;
+const int STRATEGY_CHANDY_MISRA = 3;
+const int STRATEGY_WAITER = 4;
+
+void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// 运行期间叉子只能由以它为左右叉子的哲学家持有
+void check_holders(Simulation& sim, int n, int m) {
+    SimSnapshot snap = sim.get_snapshot();
+    for (int f = 0; f < m; ++f) {
+        int h = snap.fork_holders[f];
+        if (h == -1) continue;
+        SIM_CHECK(h >= 0 && h < n);
+        int left = static_cast<int>((static_cast<long long>(h) * m) / n);
+        SIM_CHECK(f == left || f == (left + 1) % m);
+    }
+}
+
+// 统计 after 条 STRATEGY_CHANGED 事件之后的进餐次数（after = 0 表示全部）
+int meals_after_switches(const std::vector<SimEvent>& events, int after) {
+    int switches = 0, meals = 0;
+    for (const SimEvent& e : events) {
+        if (e.kind == EventKind::SYSTEM && e.reason == EventReason::STRATEGY_CHANGED) switches++;
+        if (switches >= after && e.kind == EventKind::STATE && e.reason == EventReason::EATING) meals++;
+    }
+    return meals;
+}
+
+void run_strategy(int code, int n, int m) {
+    Simulation sim(n, m);
+    sim.set_event_overflow_policy(1);
+    sim.set_strategy(code);
+    sim.start();
+    for (int i = 0; i < 6; ++i) {
+        sleep_ms(250);
+        check_holders(sim, n, m);
+    }
+    SIM_CHECK(!sim.detect_deadlock());
+    sim.stop();
+    SIM_CHECK(meals_after_switches(sim.poll_events(), 0) > 0);
+    for (int holder : sim.get_snapshot().fork_holders) SIM_CHECK(holder == -1);
+}
+
+void test_each_strategy_makes_progress() {
+    for (int code : {STRATEGY_NONE, STRATEGY_BANKER, STRATEGY_ORDERED, STRATEGY_CHANDY_MISRA, STRATEGY_WAITER}) {
+        run_strategy(code, 5, 5);
+    }
+    // N != M：Chandy–Misra 要求 N <= M，其余策略两种方向都要覆盖
+    run_strategy(STRATEGY_CHANDY_MISRA, 4, 7);
+    run_strategy(STRATEGY_ORDERED, 7, 4);
+    run_strategy(STRATEGY_WAITER, 7, 4);
+}
+
+void test_blocking_strategies_are_threaded_only() {
+    for (int code : {STRATEGY_ORDERED, STRATEGY_CHANDY_MISRA, STRATEGY_WAITER}) {
+        Simulation sim(5, 5);
+        sim.set_strategy(code);
+        SIM_CHECK_THROWS(sim.run_virtual(1.0), std::runtime_error);
+        SIM_CHECK_THROWS(sim.start_tasks(1), std::runtime_error);
+    }
+    Simulation tasks(5, 5);
+    tasks.start_tasks(1);
+    SIM_CHECK_THROWS(tasks.set_strategy(STRATEGY_ORDERED), std::runtime_error);
+    tasks.stop();
+
+    Simulation crowded(7, 4);  // 一把叉子有三位使用者
+    SIM_CHECK_THROWS(crowded.set_strategy(STRATEGY_CHANDY_MISRA), std::runtime_error);
+}
+
+void test_chandy_misra_survives_switching_back() {
+    // 切换走时协议正处于任意中间状态（叉子在信箱中、令牌在途）；切换回来后必须从一套新的状态开始，
+    // 否则可能出现无人拥有的叉子，使共享它的两位哲学家永远等待。
+    // 中间夹一段快速来回切换：旧的几套状态在仍有哲学家使用时被回收会表现为崩溃或卡住
+    const int n = 6;
+    Simulation sim(n, n);
+    sim.set_event_overflow_policy(1);
+    sim.set_strategy(STRATEGY_CHANDY_MISRA);
+    sim.start();
+    int switches_made = 1;
+    for (int round = 0; round < 3; ++round) {
+        sleep_ms(700);
+        sim.set_strategy(round % 2 == 0 ? STRATEGY_NONE : STRATEGY_ORDERED);
+        sleep_ms(300);
+        sim.set_strategy(STRATEGY_CHANDY_MISRA);
+        switches_made += 2;
+        check_holders(sim, n, n);
+    }
+    for (int i = 0; i < 100; ++i) {
+        sim.set_strategy(i % 2 == 0 ? STRATEGY_NONE : STRATEGY_CHANDY_MISRA);
+        switches_made++;
+        sleep_ms(3);
+    }
+    sim.set_strategy(STRATEGY_CHANDY_MISRA);
+    switches_made++;
+
+    // 最后一次切换回 Chandy–Misra 之后每位哲学家都吃到过（每人一餐约需 1~2 秒，至多等 15 秒）
+    std::vector<int> meals(n, 0);
+    int switches = 0;
+    auto all_ate = [&] {
+        for (int i = 0; i < n; ++i) {
+            if (meals[i] == 0) return false;
+        }
+        return true;
+    };
+    for (int waited = 0; waited < 15000 && !all_ate(); waited += 100) {
+        sleep_ms(100);
+        for (const SimEvent& e : sim.poll_events()) {
+            if (e.kind == EventKind::SYSTEM && e.reason == EventReason::STRATEGY_CHANGED) switches++;
+            if (switches >= switches_made && e.kind == EventKind::STATE && e.reason == EventReason::EATING) {
+                meals[e.phil_id]++;
+            }
+        }
+    }
+    sim.stop();
+    SIM_CHECK(switches == switches_made);
+    SIM_CHECK(all_ate());
+    for (int holder : sim.get_snapshot().fork_holders) SIM_CHECK(holder == -1);
+}
+
+} // namespace
+
+int main() {
+    run_test("each_strategy_makes_progress", test_each_strategy_makes_progress);
+    run_test("blocking_strategies_are_threaded_only", test_blocking_strategies_are_threaded_only);
+    run_test("chandy_misra_survives_switching_back", test_chandy_misra_survives_switching_back);
+    return 0;
+}
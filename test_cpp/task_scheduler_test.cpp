@@ -0,0 +1,195 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include "task_scheduler.h"
+#include "timer_wheel.h"
+#include "work_stealing_deque.h"
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 任务模式的三个部件：Chase–Lev 工作窃取双端队列、分层时间轮与 TaskScheduler；以及停止任务模式后的仿真状态
+
+namespace {
+
+void test_deque_order_and_growth() {
+    WorkStealingDeque<int> dq(2);
+    int out = 0;
+    SIM_CHECK(!dq.pop(out));
+    SIM_CHECK(!dq.steal(out));
+    for (int i = 0; i < 1000; ++i) dq.push(i);  // 多次扩容
+    SIM_CHECK(dq.size_hint() == 1000);
+    SIM_CHECK(dq.steal(out) && out == 0);    // 顶部 FIFO
+    SIM_CHECK(dq.pop(out) && out == 999);    // 底部 LIFO
+    for (int i = 998; i >= 1; --i) SIM_CHECK(dq.pop(out) && out == i);
+    SIM_CHECK(!dq.pop(out));
+    SIM_CHECK(!dq.steal(out));
+}
+
+void test_deque_concurrent_steal() {
+    // 所有者不断 push 并穿插 pop，多个窃取者同时 steal：每个元素恰好被取走一次
+    const int items = 200000;
+    const int thieves = 3;
+    WorkStealingDeque<int> dq(16);
+    std::unique_ptr<std::atomic<int>[]> taken(new std::atomic<int>[items]);
+    for (int i = 0; i < items; ++i) taken[i].store(0);
+    std::atomic<bool> done(false);
+    std::atomic<int> total(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thieves; ++t) {
+        threads.emplace_back([&] {
+            int v = 0;
+            while (!done.load() || dq.size_hint() > 0) {
+                if (dq.steal(v)) {
+                    taken[v].fetch_add(1);
+                    total.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    int v = 0;
+    for (int i = 0; i < items; ++i) {
+        dq.push(i);
+        if (i % 3 == 0 && dq.pop(v)) {
+            taken[v].fetch_add(1);
+            total.fetch_add(1);
+        }
+    }
+    while (dq.pop(v)) {
+        taken[v].fetch_add(1);
+        total.fetch_add(1);
+    }
+    done = true;
+    for (auto& t : threads) t.join();
+    SIM_CHECK(total.load() == items);
+    for (int i = 0; i < items; ++i) SIM_CHECK(taken[i].load() == 1);
+}
+
+void test_wheel_fires_each_timer_on_its_tick() {
+    // 覆盖各层与超出最高层范围（64^4 tick）的定时器，逐 tick 推进时每个定时器恰好在其到期 tick 触发一次
+    TimerWheel<int> wheel(100);
+    std::mt19937_64 rng(5);
+    std::vector<uint64_t> deadline;
+    const uint64_t ranges[] = {1, 63, 64, 4095, 4096, 262143, 262144, 16777216, 40000000};
+    for (uint64_t range : ranges) {
+        for (int k = 0; k < 20; ++k) {
+            uint64_t d = 100 + 1 + rng() % range;
+            deadline.push_back(d);
+            wheel.schedule(static_cast<int>(deadline.size() - 1), d);
+        }
+    }
+    std::vector<int> fired(deadline.size(), 0);
+    uint64_t last = 100 + 40000001;
+    for (uint64_t tick = 101; tick <= last; ++tick) {
+        wheel.advance(tick, [&](int id) {
+            SIM_CHECK(wheel.now() == deadline[id]);
+            fired[id]++;
+        });
+        if (wheel.empty()) break;
+    }
+    SIM_CHECK(wheel.size() == 0);
+    for (int f : fired) SIM_CHECK(f == 1);
+}
+
+void test_wheel_batches_and_bounds() {
+    TimerWheel<int> wheel;
+    SIM_CHECK(wheel.ticks_until_next() == std::numeric_limits<uint64_t>::max());
+    wheel.schedule(0, 0);  // 不晚于当前 tick：下一个 tick 到期
+    for (int i = 1; i <= 5; ++i) wheel.schedule(i, 300);
+    wheel.schedule(6, 5000);
+
+    std::vector<int> order;
+    auto record = [&](int id) { order.push_back(id); };
+    wheel.advance(1, record);
+    SIM_CHECK(order.size() == 1 && order[0] == 0);
+
+    // ticks_until_next 是上界：按它推进不会越过任何到期时刻
+    while (!wheel.empty()) {
+        uint64_t d = wheel.ticks_until_next();
+        SIM_CHECK(d >= 1);
+        size_t before = order.size();
+        wheel.advance(wheel.now() + d - 1, record);
+        SIM_CHECK(order.size() == before);
+        wheel.advance(wheel.now() + 1, record);
+        if (order.size() > before) {
+            SIM_CHECK(wheel.now() == 300 || wheel.now() == 5000);
+        }
+    }
+    // 同一 tick 的定时器按登记顺序触发；一次推进多个 tick 时全部到期者都被处理
+    SIM_CHECK(order.size() == 7);
+    for (int i = 1; i <= 6; ++i) SIM_CHECK(order[i] == i);
+
+    TimerWheel<int> jump;
+    for (int i = 0; i < 100; ++i) jump.schedule(i, 1 + i * 97);
+    int count = 0;
+    jump.advance(100000, [&](int) { count++; });
+    SIM_CHECK(count == 100 && jump.empty() && jump.now() == 100000);
+}
+
+void test_scheduler_runs_every_task_exclusively() {
+    const int tasks = 500;
+    std::unique_ptr<std::atomic<int>[]> steps(new std::atomic<int>[tasks]);
+    std::unique_ptr<std::atomic<bool>[]> running(new std::atomic<bool>[tasks]);
+    for (int i = 0; i < tasks; ++i) {
+        steps[i].store(0);
+        running[i].store(false);
+    }
+    std::atomic<bool> overlap(false);
+    TaskScheduler scheduler(tasks, 3, [&](int task, std::mt19937& gen) -> long long {
+        // 同一任务不会同时在两个工作线程上执行
+        if (running[task].exchange(true)) overlap = true;
+        steps[task].fetch_add(1);
+        long long delay = static_cast<long long>(gen() % 4);  // 0 表示立即再次就绪
+        running[task].store(false);
+        return delay;
+    });
+    SIM_CHECK(scheduler.num_workers() == 3);
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    scheduler.stop();
+
+    long long total = 0;
+    for (int i = 0; i < tasks; ++i) {
+        SIM_CHECK(steps[i].load() >= 2);
+        total += steps[i].load();
+    }
+    SIM_CHECK(!overlap.load());
+    // 停止后不再执行任何一步
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    long long after = 0;
+    for (int i = 0; i < tasks; ++i) after += steps[i].load();
+    SIM_CHECK(after == total);
+}
+
+void test_stop_resets_philosophers() {
+    // 64 位哲学家争 32 把叉子，停止时总有人停在 HUNGRY 或 EATING；停止后叉子全部归还、记录全部归为 THINKING
+    Simulation sim(64, 32);
+    for (int round = 0; round < 2; ++round) {
+        sim.start_tasks(2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+        sim.stop();
+        SimSnapshot snap = sim.get_snapshot();
+        for (int s : snap.states) SIM_CHECK(s == static_cast<int>(State::THINKING));
+        for (int h : snap.fork_holders) SIM_CHECK(h == -1);
+        std::vector<int> states = sim.get_states();
+        for (int s : states) SIM_CHECK(s == static_cast<int>(State::THINKING));
+    }
+}
+
+} // namespace
+
+int main() {
+    run_test("deque_order_and_growth", test_deque_order_and_growth);
+    run_test("deque_concurrent_steal", test_deque_concurrent_steal);
+    run_test("wheel_fires_each_timer_on_its_tick", test_wheel_fires_each_timer_on_its_tick);
+    run_test("wheel_batches_and_bounds", test_wheel_batches_and_bounds);
+    run_test("scheduler_runs_every_task_exclusively", test_scheduler_runs_every_task_exclusively);
+    run_test("stop_resets_philosophers", test_stop_resets_philosophers);
+    return 0;
+}
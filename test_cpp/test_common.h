@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+// C++ 单元测试的公共部分：不依赖第三方测试框架，每个 *_test.cpp 是一个可执行文件，由 ctest 按退出码判定。
+// SIM_CHECK 失败时打印位置并立即以非零退出码结束；run_test 打印用例名并把未捕获的异常视为失败
+
+#define SIM_CHECK(cond)                                                                    \
+    do {                                                                                   \
+        if (!(cond)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);  \
+            std::exit(1);                                                                  \
+        }                                                                                  \
+    } while (0)
+
+// 期望表达式抛出 ExceptionType
+#define SIM_CHECK_THROWS(expr, ExceptionType)                                              \
+    do {                                                                                   \
+        bool thrown = false;                                                               \
+        try {                                                                              \
+            expr;                                                                          \
+        } catch (const ExceptionType&) {                                                   \
+            thrown = true;                                                                 \
+        }                                                                                  \
+        if (!thrown) {                                                                     \
+            std::fprintf(stderr, "%s:%d: expected %s from: %s\n", __FILE__, __LINE__,      \
+                         #ExceptionType, #expr);                                           \
+            std::exit(1);                                                                  \
+        }                                                                                  \
+    } while (0)
+
+template<typename Func>
+void run_test(const char* name, Func&& func) {
+    std::printf("[ RUN  ] %s\n", name);
+    std::fflush(stdout);
+    try {
+        func();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: unexpected exception: %s\n", name, e.what());
+        std::exit(1);
+    }
+    std::printf("[  OK  ] %s\n", name);
+}
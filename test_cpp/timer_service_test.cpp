@@ -0,0 +1,129 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include "timer_service.h"
+#include "win_sync.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// 共享定时器服务（timer_service.h）：sleep / wait 的时长、被其他线程提前唤醒、stop 唤醒全部等待者，
+// 以及 Simulation 的 WHEEL 定时器模式
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+void test_sleep_and_timeout() {
+    TimerService timers(4);
+    timers.start();
+
+    auto begin = Clock::now();
+    timers.sleep(0, 30);
+    long long slept = elapsed_ms(begin);
+    SIM_CHECK(slept >= 29 && slept < 1000);
+
+    WinSemaphore sem(0, 1);
+    begin = Clock::now();
+    SIM_CHECK(!timers.wait(1, sem, 40));  // 无人 post：超时
+    long long waited = elapsed_ms(begin);
+    SIM_CHECK(waited >= 39 && waited < 1000);
+    SIM_CHECK(!sem.try_wait(0));          // 服务线程代为 post 的那一次已被 wait 消耗
+
+    timers.stop();
+}
+
+void test_wait_woken_by_post() {
+    TimerService timers(2);
+    timers.start();
+    WinSemaphore sem(0, 1);
+    std::thread poster([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sem.post();
+    });
+    auto begin = Clock::now();
+    SIM_CHECK(timers.wait(0, sem, 5000));
+    SIM_CHECK(elapsed_ms(begin) < 2000);
+    poster.join();
+    timers.stop();
+}
+
+void test_many_sleepers() {
+    const int n = 64;
+    TimerService timers(n);
+    timers.start();
+    std::atomic<int> done(0);
+    std::vector<std::thread> threads;
+    auto begin = Clock::now();
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&, i] {
+            for (int k = 0; k < 5; ++k) timers.sleep(i, static_cast<DWORD>(5 + (i + k) % 20));
+            done.fetch_add(1);
+        });
+    }
+    for (auto& t : threads) t.join();
+    SIM_CHECK(done.load() == n);
+    SIM_CHECK(elapsed_ms(begin) >= 25);
+    timers.stop();
+}
+
+void test_stop_releases_waiters() {
+    TimerService timers(3);
+    timers.start();
+    WinSemaphore sem(0, 1);
+    std::atomic<int> finished(0);
+    std::thread sleeper([&] {
+        timers.sleep(0, 60000);
+        finished.fetch_add(1);
+    });
+    std::thread waiter([&] {
+        SIM_CHECK(!timers.wait(1, sem, 60000));  // 被 stop 唤醒按超时返回
+        finished.fetch_add(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto begin = Clock::now();
+    timers.stop();
+    sleeper.join();
+    waiter.join();
+    SIM_CHECK(finished.load() == 2);
+    SIM_CHECK(elapsed_ms(begin) < 2000);
+
+    // 停止后 sleep 立即返回，wait 退化为不等待的 try_wait
+    begin = Clock::now();
+    timers.sleep(2, 5000);
+    SIM_CHECK(!timers.wait(2, sem, 5000));
+    SIM_CHECK(elapsed_ms(begin) < 1000);
+}
+
+void test_simulation_wheel_mode() {
+    Simulation sim(12, 12);
+    sim.set_timer_mode(1);
+    sim.set_event_overflow_policy(1);
+    sim.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+    // 所有定时等待都登记在时间轮上，stop 时立即结束，不必等思考或进餐的剩余时长
+    auto begin = Clock::now();
+    sim.stop();
+    SIM_CHECK(elapsed_ms(begin) < 500);
+    int meals = 0;
+    for (const SimEvent& e : sim.poll_events()) {
+        if (e.kind == EventKind::STATE && e.reason == EventReason::EATING) meals++;
+    }
+    SIM_CHECK(meals > 0);
+    for (int holder : sim.get_snapshot().fork_holders) SIM_CHECK(holder == -1);
+}
+
+} // namespace
+
+int main() {
+    run_test("sleep_and_timeout", test_sleep_and_timeout);
+    run_test("wait_woken_by_post", test_wait_woken_by_post);
+    run_test("many_sleepers", test_many_sleepers);
+    run_test("stop_releases_waiters", test_stop_releases_waiters);
+    run_test("simulation_wheel_mode", test_simulation_wheel_mode);
+    return 0;
+}
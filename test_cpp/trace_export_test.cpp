@@ -0,0 +1,98 @@
+﻿#include "test_common.h"
+#include "simulation.h"
+#include "trace_recorder.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 时间线追踪（trace_recorder.h）：记录器的线程私有缓冲区与丢弃计数、Chrome Trace JSON 的写出，
+// 以及 Simulation::set_trace_output 的参数检查与写出时机（文件在 ctest 的工作目录下创建并删除）
+
+namespace {
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+void write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+}
+
+size_t count_of(const std::string& text, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) n++;
+    return n;
+}
+
+void test_recorder_threads_and_limit() {
+    const std::string path = "trace_export_test_recorder.json";
+    TraceRecorder recorder(1000, 100);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&recorder, t] {
+            // 每个线程 150 条，超出上限的 50 条丢弃
+            for (int i = 0; i < 75; ++i) {
+                recorder.span(t, TraceName::EATING, 1000 + i * 10000, 5000);
+                recorder.instant(t, TraceName::ACQUIRE_FORK, 2000 + i * 10000, t);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    SIM_CHECK(recorder.write(path, 3));
+
+    std::string json = read_file(path);
+    SIM_CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+    SIM_CHECK(json.find("\"dropped_events\":150") != std::string::npos);
+    SIM_CHECK(count_of(json, "\"ph\":\"X\"") + count_of(json, "\"ph\":\"i\"") == 300);
+    SIM_CHECK(count_of(json, "\"name\":\"thread_name\"") == 3);
+    SIM_CHECK(json.find("\"ts\":0.000,\"ph\":\"X\",\"dur\":5.000") != std::string::npos);  // 以 origin 为零点，微秒
+    std::remove(path.c_str());
+}
+
+void test_invalid_arguments() {
+    Simulation sim(3, 3);
+    SIM_CHECK_THROWS(sim.set_trace_output("trace_export_test.json", 0), std::runtime_error);
+    SIM_CHECK_THROWS(sim.set_trace_output("no_such_directory/trace.json"), std::runtime_error);
+    sim.set_trace_output("");  // 关闭追踪总是允许
+}
+
+void test_simulation_export_keeps_previous_file_until_written() {
+    const std::string path = "trace_export_test.json";
+    write_file(path, "previous trace");
+    Simulation sim(5, 5);
+    sim.set_trace_output(path);
+    // 设置时只检查可写，不清空上一次的结果
+    SIM_CHECK(read_file(path) == "previous trace");
+
+    SimStats stats = sim.run_virtual(10.0, 1);
+    SIM_CHECK(stats.total_meals > 0);
+    std::string json = read_file(path);
+    SIM_CHECK(json.find("previous trace") == std::string::npos);
+    SIM_CHECK(json.find("\"dropped_events\":0") != std::string::npos);
+    SIM_CHECK(count_of(json, "\"name\":\"EATING\"") == static_cast<size_t>(stats.total_meals));
+    SIM_CHECK(count_of(json, "\"name\":\"thread_name\"") == 5);
+
+    // 关闭后再运行不再写出
+    std::remove(path.c_str());
+    sim.set_trace_output("");
+    sim.run_virtual(1.0, 1);
+    std::ifstream missing(path);
+    SIM_CHECK(!missing.good());
+}
+
+} // namespace
+
+int main() {
+    run_test("recorder_threads_and_limit", test_recorder_threads_and_limit);
+    run_test("invalid_arguments", test_invalid_arguments);
+    run_test("simulation_export_keeps_previous_file_until_written", test_simulation_export_keeps_previous_file_until_written);
+    return 0;
+}
@@ -0,0 +1,150 @@
+﻿#include "test_common.h"
+#include "win_sync.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 同步原语（win_sync.h）：WinMutex 的可重入计数与跨线程 try_lock、争用下的互斥，
+// WinSemaphore 的计数、max_count 截断、超时与阻塞唤醒。Linux 上按 pthread 与 futex 两个后端各编译运行一次
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+// 在另一个线程上尝试加锁，成功则立即释放
+bool try_lock_from_other_thread(WinMutex& m) {
+    bool acquired = false;
+    std::thread other([&] {
+        acquired = m.try_lock();
+        if (acquired) m.unlock();
+    });
+    other.join();
+    return acquired;
+}
+
+void test_recursive_lock_counts() {
+    WinMutex m;
+    m.lock();
+    m.lock();
+    SIM_CHECK(m.try_lock());              // 持有者再次 try_lock 也是重入
+    SIM_CHECK(!try_lock_from_other_thread(m));
+    m.unlock();
+    SIM_CHECK(!try_lock_from_other_thread(m));
+    m.unlock();
+    SIM_CHECK(!try_lock_from_other_thread(m));  // 仍有一层未释放
+    m.unlock();
+    SIM_CHECK(try_lock_from_other_thread(m));
+    // 其他线程释放后，本线程可以重新获取
+    SIM_CHECK(m.try_lock());
+    m.unlock();
+}
+
+void test_try_lock_from_non_owner() {
+    WinMutex m;
+    std::atomic<bool> held(false);
+    std::atomic<bool> release(false);
+    std::thread owner([&] {
+        WinLockGuard guard(m);
+        held.store(true);
+        while (!release.load()) std::this_thread::yield();
+    });
+    while (!held.load()) std::this_thread::yield();
+    auto begin = Clock::now();
+    SIM_CHECK(!m.try_lock());             // 不阻塞，立即失败
+    SIM_CHECK(elapsed_ms(begin) < 1000);
+    release.store(true);
+    owner.join();
+    SIM_CHECK(m.try_lock());
+    m.unlock();
+}
+
+void test_mutual_exclusion_under_contention() {
+    const int threads = 4;
+    const int per_thread = 100000;
+    WinMutex m;
+    long long counter = 0;  // 只在锁内读写
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < per_thread; ++i) {
+                WinLockGuard guard(m);
+                WinLockGuard nested(m);
+                ++counter;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    SIM_CHECK(counter == static_cast<long long>(threads) * per_thread);
+}
+
+void test_semaphore_counts() {
+    WinSemaphore sem(0, 8);
+    const int n = 5;
+    for (int i = 0; i < n; ++i) sem.post();
+    for (int i = 0; i < n; ++i) SIM_CHECK(sem.try_wait(0));
+    SIM_CHECK(!sem.try_wait(0));
+
+    // 超过 max_count 的 post 被忽略（与 ReleaseSemaphore 一致）
+    WinSemaphore capped(1, 3);
+    for (int i = 0; i < 10; ++i) capped.post();
+    for (int i = 0; i < 3; ++i) capped.wait();
+    SIM_CHECK(!capped.try_wait(0));
+
+    SIM_CHECK_THROWS(WinSemaphore(2, 1), std::runtime_error);
+    SIM_CHECK_THROWS(WinSemaphore(-1, 1), std::runtime_error);
+    SIM_CHECK_THROWS(WinSemaphore(0, 0), std::runtime_error);
+}
+
+void test_semaphore_timeout() {
+    WinSemaphore sem(0, 1);
+    auto begin = Clock::now();
+    SIM_CHECK(!sem.try_wait(50));
+    long long waited = elapsed_ms(begin);
+    SIM_CHECK(waited >= 49 && waited < 2000);
+}
+
+void test_semaphore_wakes_blocked_waiters() {
+    const int waiters = 4;
+    WinSemaphore sem(0, waiters);
+    std::atomic<int> woken(0);
+    std::atomic<int> timed_out(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < waiters; ++i) {
+        threads.emplace_back([&, i] {
+            if (i % 2 == 0) {
+                sem.wait();
+                woken.fetch_add(1);
+            } else if (sem.try_wait(10000)) {
+                woken.fetch_add(1);
+            } else {
+                timed_out.fetch_add(1);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto begin = Clock::now();
+    for (int i = 0; i < waiters; ++i) sem.post();
+    for (auto& t : threads) t.join();
+    SIM_CHECK(woken.load() == waiters);
+    SIM_CHECK(timed_out.load() == 0);
+    SIM_CHECK(elapsed_ms(begin) < 2000);
+    SIM_CHECK(!sem.try_wait(0));
+}
+
+} // namespace
+
+int main() {
+    run_test("recursive_lock_counts", test_recursive_lock_counts);
+    run_test("try_lock_from_non_owner", test_try_lock_from_non_owner);
+    run_test("mutual_exclusion_under_contention", test_mutual_exclusion_under_contention);
+    run_test("semaphore_counts", test_semaphore_counts);
+    run_test("semaphore_timeout", test_semaphore_timeout);
+    run_test("semaphore_wakes_blocked_waiters", test_semaphore_wakes_blocked_waiters);
+    return 0;
+}
@@ -97,17 +97,22 @@ class BoundaryTester:
         time.sleep(60)
         
         events = sim.poll_events()
+        log_stats = sim.get_event_log_stats()
         sim.stop()
         
-        # 根据代码，队列最大5000条
+        # 事件环形队列有界：收集到的事件数不超过容量，溢出部分体现在覆盖/丢弃计数中
         result = {
             "name": "事件队列溢出",
             "config": "10P+9F, 60s",
             "events_collected": len(events),
-            "passed": True  # 只要不崩溃就算通过
+            "capacity": log_stats.capacity,
+            "overwritten": log_stats.overwritten,
+            "dropped": log_stats.dropped,
+            "passed": len(events) <= log_stats.capacity
         }
         
-        print(f"✓ 收集事件数: {result['events_collected']}")
+        print(f"✓ 收集事件数: {result['events_collected']} (容量 {result['capacity']})")
+        print(f"✓ 覆盖/丢弃: {result['overwritten']} / {result['dropped']}")
         print(f"✓ 结果: {'✅ PASS (队列正常)' if result['passed'] else '❌ FAIL'}")
         
         self.results.append(result)